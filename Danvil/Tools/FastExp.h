@@ -0,0 +1,146 @@
+/*
+ * FastExp.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef DANVIL_TOOLS_FASTEXP_H_
+#define DANVIL_TOOLS_FASTEXP_H_
+//---------------------------------------------------------------------------
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#if defined(__AVX2__) && defined(__FMA__)
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+//---------------------------------------------------------------------------
+namespace Danvil {
+//---------------------------------------------------------------------------
+
+/** Approximation of exp(-x) for float
+ * The argument is reduced with exp(-x) = 2^n * exp(r) where n = round(-x/ln2)
+ * and |r| <= ln2/2. exp(r) is evaluated with a polynomial of degree 7 and 2^n
+ * is assembled directly in the exponent bits.
+ * Arguments are clamped to [-cMaxArg,cMaxArg] (no overflow or denormals).
+ * Maximal relative error is 1e-7 (about 1 ulp) on the whole range, i.e. the
+ * approximation is as accurate as std::exp for float.
+ */
+namespace FastExp {
+
+	constexpr float cMaxArg = 87.0f;
+	constexpr float cLog2e = 1.44269504089f;
+	// ln2 split in a part with few mantissa bits (exact product with n) and a remainder
+	constexpr float cLn2Hi = 0.693359375f;
+	constexpr float cLn2Lo = -2.12194440e-4f;
+	// polynomial coefficients of exp(r) - 1 - r (Cephes expf)
+	constexpr float cP0 = 1.9875691500e-4f;
+	constexpr float cP1 = 1.3981999507e-3f;
+	constexpr float cP2 = 8.3334519073e-3f;
+	constexpr float cP3 = 4.1665795894e-2f;
+	constexpr float cP4 = 1.6666665459e-1f;
+	constexpr float cP5 = 5.0000001201e-1f;
+
+}
+
+/** exp(-x) for a single value
+ * A single lane of the polynomial is not faster than the table based std::exp of
+ * the C library, so this only forwards to std::exp. Use ExpNeg8 or the array
+ * version of ExpNeg in loops.
+ */
+inline float ExpNeg(float x)
+{
+	return std::exp(-x);
+}
+
+inline double ExpNeg(double x)
+{
+	return std::exp(-x);
+}
+
+/** Computes y[i] = exp(-x[i]) for i=0..7 with the approximation described in FastExp */
+inline void ExpNeg8(const float* x, float* y)
+{
+	using namespace FastExp;
+#if defined(__AVX2__) && defined(__FMA__)
+	__m256 v = _mm256_loadu_ps(x);
+	v = _mm256_min_ps(_mm256_set1_ps(cMaxArg), _mm256_max_ps(_mm256_set1_ps(-cMaxArg), v));
+	v = _mm256_sub_ps(_mm256_setzero_ps(), v);
+	const __m256 n = _mm256_round_ps(_mm256_mul_ps(v, _mm256_set1_ps(cLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(cLn2Hi), v);
+	r = _mm256_fnmadd_ps(n, _mm256_set1_ps(cLn2Lo), r);
+	__m256 p = _mm256_set1_ps(cP0);
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(cP1));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(cP2));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(cP3));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(cP4));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(cP5));
+	const __m256 q = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+	const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+	_mm256_storeu_ps(y, _mm256_mul_ps(q, _mm256_castsi256_ps(bits)));
+#elif defined(__SSE2__)
+	for(unsigned int k=0; k<8; k+=4) {
+		__m128 v = _mm_loadu_ps(x + k);
+		v = _mm_min_ps(_mm_set1_ps(cMaxArg), _mm_max_ps(_mm_set1_ps(-cMaxArg), v));
+		v = _mm_sub_ps(_mm_setzero_ps(), v);
+		// conversion rounds to nearest
+		const __m128i ni = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(cLog2e)));
+		const __m128 n = _mm_cvtepi32_ps(ni);
+		__m128 r = _mm_sub_ps(v, _mm_mul_ps(n, _mm_set1_ps(cLn2Hi)));
+		r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(cLn2Lo)));
+		__m128 p = _mm_set1_ps(cP0);
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(cP1));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(cP2));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(cP3));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(cP4));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(cP5));
+		const __m128 q = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+		const __m128i bits = _mm_slli_epi32(_mm_add_epi32(ni, _mm_set1_epi32(127)), 23);
+		_mm_storeu_ps(y + k, _mm_mul_ps(q, _mm_castsi128_ps(bits)));
+	}
+#else
+	for(unsigned int k=0; k<8; k++) {
+		y[k] = std::exp(-std::min(cMaxArg, std::max(-cMaxArg, x[k])));
+	}
+#endif
+}
+
+/** exp(-x) for a single value with the approximation of ExpNeg8
+ * Gives bitwise the same result as ExpNeg8 and the array version of ExpNeg,
+ * but is slower than ExpNeg(float).
+ */
+inline float ExpNegApprox(float x)
+{
+	float xt[8] = {x, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	float yt[8];
+	ExpNeg8(xt, yt);
+	return yt[0];
+}
+
+inline double ExpNegApprox(double x)
+{
+	return std::exp(-x);
+}
+
+/** Computes y[i] = exp(-x[i]) for i=0..n-1 in blocks of 8 */
+inline void ExpNeg(const float* x, float* y, std::size_t n)
+{
+	std::size_t i = 0;
+	for(; i+8<=n; i+=8) {
+		ExpNeg8(x + i, y + i);
+	}
+	if(i < n) {
+		float xt[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+		float yt[8];
+		std::copy(x + i, x + n, xt);
+		ExpNeg8(xt, yt);
+		std::copy(yt, yt + (n - i), y + i);
+	}
+}
+
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
@@ -9,6 +9,7 @@
 #define DANVIL_FUNCTIONCACHE_H_
 //---------------------------------------------------------------------------
 #include "MoreMath.h"
+#include "FastExp.h"
 #include <cassert>
 //---------------------------------------------------------------------------
 namespace Danvil {
@@ -94,37 +95,30 @@ template<typename V, unsigned int Order, typename K> struct FunctionCache<V,Orde
 
 //---------------------------------------------------------------------------
 
+/** Computes exp(-x) with the FastExp approximation (no table, the template parameters are only kept for compatibility)
+ * Single values and arrays give the same results.
+ */
 template<typename K, unsigned int InterpolationOrder=0, size_t N=Private::SelectNumberByType<K>::Result>
 struct ExpNegFunctionCache
-: FunctionCache<K,InterpolationOrder,N,K>
 {
-private:
-public:
-	ExpNegFunctionCache()
-	: FunctionCache<K,InterpolationOrder,N,K>(0, Private::ExpRangeByType<K>::Result, &evaluate) {
+	K operator()(K x) const {
+		return ExpNegApprox(x);
 	}
 
-private:
-	static K evaluate(K x) {
-		return std::exp(-x);
+	/** Computes y[i] = exp(-x[i]) for i=0..n-1 */
+	void operator()(const float* x, float* y, size_t n) const {
+		ExpNeg(x, y, n);
 	}
 };
 
 //---------------------------------------------------------------------------
 
+/** Computes exp(-x/2) with std::exp (no table, the template parameters are only kept for compatibility) */
 template<typename K, unsigned int InterpolationOrder=0, size_t N=Private::SelectNumberByType<K>::Result>
 struct ProbabilityExpFunctionCache
-: FunctionCache<K,InterpolationOrder,N,K>
 {
-private:
-public:
-	ProbabilityExpFunctionCache()
-	: FunctionCache<K,InterpolationOrder,N,K>(0, K(2) * Private::ExpRangeByType<K>::Result, &evaluate) {
-	}
-
-private:
-	static K evaluate(K x) {
-		return std::exp(-K(0.5)*x);
+	K operator()(K x) const {
+		return ExpNeg(K(0.5)*x);
 	}
 };
 
@@ -0,0 +1,108 @@
+/*
+ * Parallel.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef DANVIL_TOOLS_PARALLEL_H_
+#define DANVIL_TOOLS_PARALLEL_H_
+//---------------------------------------------------------------------------
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+//---------------------------------------------------------------------------
+namespace Danvil {
+//---------------------------------------------------------------------------
+
+/** Number of hardware threads (at least 1) */
+inline unsigned int ThreadCount() {
+	unsigned int n = std::thread::hardware_concurrency();
+	return (n == 0) ? 1 : n;
+}
+
+/** Number of chunks of size chunk_size required to cover [0,n[ */
+inline std::size_t ChunkCount(std::size_t n, std::size_t chunk_size) {
+	return (n + chunk_size - 1) / chunk_size;
+}
+
+/** Number of worker threads used by ParallelChunks for n items */
+inline unsigned int WorkerCount(std::size_t n, std::size_t chunk_size, unsigned int num_threads=ThreadCount())
+{
+	const std::size_t num_chunks = ChunkCount(n, std::max<std::size_t>(chunk_size, 1));
+	return static_cast<unsigned int>(std::min<std::size_t>(std::max(num_threads, 1u), num_chunks));
+}
+
+/** Like ParallelChunks, but calls f(worker, chunk, begin, end)
+ * The worker index is in [0,WorkerCount(n,chunk_size,num_threads)[ and no two
+ * chunks with the same worker index are processed at the same time. It can be
+ * used to give each worker its own preallocated buffers.
+ * f must not throw.
+ */
+template<typename F>
+void ParallelWorkerChunks(std::size_t n, std::size_t chunk_size, F f, unsigned int num_threads=ThreadCount())
+{
+	if(n == 0) {
+		return;
+	}
+	chunk_size = std::max<std::size_t>(chunk_size, 1);
+	const std::size_t num_chunks = ChunkCount(n, chunk_size);
+	const unsigned int num_workers = WorkerCount(n, chunk_size, num_threads);
+	std::atomic<std::size_t> next_chunk(0);
+	auto worker = [n, chunk_size, num_chunks, &next_chunk, &f](unsigned int w) {
+		for(std::size_t k=next_chunk++; k<num_chunks; k=next_chunk++) {
+			const std::size_t begin = k * chunk_size;
+			const std::size_t end = std::min(begin + chunk_size, n);
+			f(w, k, begin, end);
+		}
+	};
+	if(num_workers == 1) {
+		worker(0);
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(num_workers - 1);
+	for(unsigned int i=1; i<num_workers; i++) {
+		threads.push_back(std::thread(worker, i));
+	}
+	worker(0);
+	for(std::thread& t : threads) {
+		t.join();
+	}
+}
+
+/** Calls f(chunk, begin, end) for all chunks [begin,end[ of size chunk_size covering [0,n[
+ * Chunks are processed in parallel by worker threads. The chunk layout only
+ * depends on n and chunk_size, so per-chunk results merged in chunk order
+ * are identical for any number of threads.
+ * f must not throw.
+ */
+template<typename F>
+void ParallelChunks(std::size_t n, std::size_t chunk_size, F f, unsigned int num_threads=ThreadCount())
+{
+	ParallelWorkerChunks(n, chunk_size,
+		[&f](unsigned int, std::size_t k, std::size_t begin, std::size_t end) {
+			f(k, begin, end);
+		},
+		num_threads);
+}
+
+/** Calls f(i) for all i in [0,n[ in parallel */
+template<typename F>
+void ParallelFor(std::size_t n, F f, std::size_t chunk_size=64, unsigned int num_threads=ThreadCount())
+{
+	ParallelChunks(n, chunk_size,
+		[&f](std::size_t, std::size_t begin, std::size_t end) {
+			for(std::size_t i=begin; i<end; i++) {
+				f(i);
+			}
+		},
+		num_threads);
+}
+
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
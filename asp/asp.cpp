@@ -56,6 +56,7 @@ namespace asp
 		Parameters p;
 		p.num_iterations = 5;
 		p.pds_mode = "spds";
+		p.random_seed = 0;
 		p.seed_mean_radius_factor = 0.25f;
 		p.coverage = 3.0f;
 		p.weight_compact = 1.0f;
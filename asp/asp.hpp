@@ -147,6 +147,7 @@ namespace asp
 	{
 		int num_iterations;
 		std::string pds_mode;
+		unsigned int random_seed;
 		float seed_mean_radius_factor;
 		float coverage;
 		float weight_compact;
@@ -172,7 +173,8 @@ namespace asp
 		const int width = density.rows();
 		Superpixels<F> sp;
 		// seed clusters
-		std::vector<Eigen::Vector2f> pnts = pds::PoissonDiscSampling(p.pds_mode, density, seeds);
+		pds::Rng rng(p.random_seed);
+		std::vector<Eigen::Vector2f> pnts = pds::PoissonDiscSampling(p.pds_mode, rng, density, seeds);
 		sp.clusters.resize(pnts.size());
 		std::transform(pnts.begin(), pnts.end(), sp.clusters.begin(),
 			[&density, &features, mean, &p](const Eigen::Vector2f& pnt) {
@@ -91,6 +91,7 @@ int main(int argc, char** argv)
 		("num", po::value(&p_num), "number of points to sample")
 		("p_num_iterations", po::value(&params.num_iterations), "number of DALIC iterations")
 		("p_pds_mode", po::value(&params.pds_mode), "Poisson Disk Sampling method")
+		("p_random_seed", po::value(&params.random_seed), "random number seed for Poisson Disk Sampling")
 		("p_seed_mean_radius_factor", po::value(&params.seed_mean_radius_factor), "size factor for initial cluster mean feature")
 		("p_coverage", po::value(&params.coverage), "DALIC cluster search factor")
 		("p_weight_compact", po::value(&params.weight_compact), "weight for compactness term")
@@ -9,10 +9,12 @@
 #include <slimage/io.hpp>
 #include <slimage/image.hpp>
 #include <slimage/gui.hpp>
+#include <Danvil/Tools/Benchmark.h>
 #include <boost/program_options.hpp>
 #include <boost/format.hpp>
 #include <boost/progress.hpp>
 #include <iostream>
+#include <chrono>
 
 
 
@@ -35,6 +37,8 @@ int main(int argc, char** argv)
 	bool p_save_labels = false;
 	bool p_save_density = false;
 	bool p_save_graph = false;
+	std::string p_spectral = "";
+	bool p_spectral_warm_start = true;
 
 	dasp::Parameters opt;
 	opt.camera = dasp::Camera{320.0f, 240.0f, 540.0f, 0.001f};
@@ -69,6 +73,8 @@ int main(int argc, char** argv)
 		("save_labels", po::value(&p_save_labels)->default_value(p_save_labels), "enable to write dasp pixel cluster labels")
 		("save_density", po::value(&p_save_density)->default_value(p_save_density), "enable to write dasp target and point density")
 		("save_graph", po::value(&p_save_graph)->default_value(p_save_graph), "enable to write dasp graph to file")
+		("spectral", po::value(&p_spectral), "runs spectral segmentation and reports solver iterations and time per frame (eigen, lapack, lanczos, lobpcg, auto)")
+		("spectral_warm_start", po::value(&p_spectral_warm_start)->default_value(p_spectral_warm_start), "starts iterative spectral solvers with the eigenvectors of the previous frame")
 	;
 
 	po::variables_map vm;
@@ -95,6 +101,27 @@ int main(int argc, char** argv)
 		opt.seed_mode = dasp::SeedModes::Delta;
 	}
 
+	graphseg::SpectralMethod spectral_method = graphseg::SpectralMethod::Eigen;
+	if(p_spectral == "eigen") {
+		spectral_method = graphseg::SpectralMethod::Eigen;
+	}
+	else if(p_spectral == "lapack") {
+		spectral_method = graphseg::SpectralMethod::Lapack;
+	}
+	else if(p_spectral == "lanczos") {
+		spectral_method = graphseg::SpectralMethod::Lanczos;
+	}
+	else if(p_spectral == "lobpcg") {
+		spectral_method = graphseg::SpectralMethod::Lobpcg;
+	}
+	else if(p_spectral == "auto") {
+		spectral_method = graphseg::SpectralMethod::Auto;
+	}
+	else if(!p_spectral.empty()) {
+		std::cerr << "ERROR: Unknown spectral solver '" << p_spectral << "'!" << std::endl;
+		return 1;
+	}
+
 	std::shared_ptr<RgbdStream> stream = FactorStream(p_rgbd_mode, p_rgbd_arg);
 
 	boost::format fn_result_fmt(p_out + "%05d");
@@ -103,11 +130,18 @@ int main(int argc, char** argv)
 	superpixels.opt = opt;
 
 	boost::shared_ptr<boost::progress_display> progress;
-	bool show_cmd_progressbar = p_verbose == 0 && p_num_frames >= 1;
+	bool show_cmd_progressbar = p_verbose == 0 && p_num_frames >= 1 && p_spectral.empty();
 	if(show_cmd_progressbar) {
 		progress.reset(new boost::progress_display(p_num_frames));
 	}
 
+	// spectral solution of the previous frame
+	std::vector<Eigen::Vector2f> spectral_previous_centers;
+	graphseg::SpectralSubspace spectral_previous;
+	unsigned int spectral_total_iterations = 0;
+	double spectral_total_time = 0.0;
+	unsigned int spectral_num_frames = 0;
+
 	int frame_id = p_out_start_index;
 	while(stream->grab()) {
 		// check if maximum number of frames is reached
@@ -129,7 +163,8 @@ int main(int argc, char** argv)
 		slimage::Image3ub vis_dasp;
 		dasp::DaspGraph graph;
 
-		bool needs_superpixels = (p_verbose >= 2) || (output_enabled && (
+		bool needs_spectral = !p_spectral.empty();
+		bool needs_superpixels = (p_verbose >= 2) || needs_spectral || (output_enabled && (
 			p_save_vis_dasp || p_save_cluster || p_save_labels || p_save_density || p_save_graph));
 		bool needs_vis_dasp = (p_verbose >= 2) || (output_enabled && p_save_vis_dasp);
 		bool needs_labels = needs_vis_dasp || (output_enabled && p_save_labels);
@@ -174,6 +209,32 @@ int main(int argc, char** argv)
 			graph = dasp::CreateDaspNeighbourhoodGraph(superpixels);
 		}
 
+		// spectral segmentation (warm started with the solution of the previous frame)
+		if(needs_spectral) {
+			assert(needs_superpixels);
+			dasp::NeighbourhoodGraph Gnb = dasp::CreateNeighborhoodGraph(superpixels, dasp::NeighborGraphSettings::NoCut());
+			dasp::UndirectedWeightedGraph similarity = dasp::ComputeEdgeWeights(superpixels, Gnb,
+				dasp::ClassicSpectralAffinity<true>(superpixels.clusterCount(), superpixels.opt.base_radius, 1.0f, 2.0f, 3.0f));
+			graphseg::SpectralSubspace initial_guess;
+			if(p_spectral_warm_start && spectral_previous.eigenvectors.size() > 0) {
+				initial_guess = graphseg::MapSpectralSubspace(spectral_previous,
+					dasp::ComputeClusterCorrespondence(spectral_previous_centers, superpixels));
+			}
+			const auto time_start = std::chrono::steady_clock::now();
+			dasp::SpectralSegmentation(similarity, boost::get(boost::edge_bundle, similarity),
+				spectral_method, initial_guess, &spectral_previous);
+			const double t = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+			spectral_previous_centers = superpixels.getClusterCentersAsPoints();
+			spectral_total_iterations += spectral_previous.iterations;
+			spectral_total_time += t;
+			spectral_num_frames ++;
+			std::cout << "frame=" << frame_id << " spectral=" << p_spectral
+				<< " warm_start=" << (initial_guess.eigenvectors.size() > 0)
+				<< " nodes=" << boost::num_vertices(similarity)
+				<< " iterations=" << spectral_previous.iterations
+				<< " time=" << t << "ms" << std::endl;
+		}
+
 		// show basic images
 		if(p_verbose >= 2) {
 			slimage::GuiShow("dasp", vis_dasp);
@@ -275,6 +336,17 @@ int main(int argc, char** argv)
 		}
 	}
 
+	if(spectral_num_frames > 0) {
+		std::cout << "spectral=" << p_spectral
+			<< " frames=" << spectral_num_frames
+			<< " mean_iterations=" << static_cast<double>(spectral_total_iterations) / static_cast<double>(spectral_num_frames)
+			<< " mean_time=" << spectral_total_time / static_cast<double>(spectral_num_frames) << "ms" << std::endl;
+		if(spectral_method == graphseg::SpectralMethod::Auto) {
+			// time per selected solver
+			DANVIL_BENCHMARK_PRINTALL_COUT
+		}
+	}
+
 	if(p_verbose >= 2) {
 		slimage::GuiWait();
 	}
@@ -225,13 +225,11 @@ void DaspProcessing::performSegmentationStep()
 					slimage::Fill(vis_img, {255,255,255});
 					const float T = clustering_.opt.segment_threshold;
 					for(auto eid : as_range(boost::edges(dasp_segment_graph))) {
-						int i = boost::source(eid, dasp_segment_graph);
-						int j = boost::target(eid, dasp_segment_graph);
 						float q = dasp_segment_graph[eid] /(2.0f*T);
 						unsigned char g = static_cast<unsigned char>(255.0f*(1.0f - q));
 						slimage::Pixel3ub color{{g,g,g}};
-						dasp::NeighbourhoodGraph::edge_descriptor e = boost::edge(i, j, Gnb).first;
-						for(int k : Gnb[e].border_pixel_ids) { 
+						// the segment graph shares the topology of Gnb
+						for(int k : BorderPixelIds(Gnb, eid)) {
 							vis_img[k] = color;
 						}
 					}
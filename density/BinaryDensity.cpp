@@ -0,0 +1,159 @@
+/*
+ * BinaryDensity.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "BinaryDensity.hpp"
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace density
+{
+
+	namespace binary
+	{
+		uint64_t Checksum(const float* data, std::size_t n)
+		{
+			constexpr uint64_t cOffset = 14695981039346656037ull;
+			constexpr uint64_t cPrime = 1099511628211ull;
+			uint64_t h = cOffset;
+			for(std::size_t i=0; i<n; i++) {
+				uint32_t w;
+				std::memcpy(&w, data + i, sizeof(w));
+				h = (h ^ w) * cPrime;
+			}
+			return h;
+		}
+
+		/** Checks a header for a file with the given number of bytes after the header
+		 * @return an error message or 0 if the header is valid
+		 */
+		const char* CheckHeader(const Header& header, std::size_t data_size)
+		{
+			if(std::memcmp(header.magic, cMagic, sizeof(header.magic)) != 0) {
+				return "invalid header";
+			}
+			if(header.version != cVersion) {
+				return "unsupported version";
+			}
+			if(header.dtype != static_cast<uint32_t>(DType::Float32)) {
+				return "unsupported data type";
+			}
+			// checked with a division as width*height could overflow for a corrupt header
+			if(header.width != 0 && header.height > (data_size / sizeof(float)) / header.width) {
+				return "size does not match header";
+			}
+			if(data_size != static_cast<std::size_t>(header.width)*header.height*sizeof(float)) {
+				return "size does not match header";
+			}
+			return 0;
+		}
+	}
+
+	bool IsBinaryDensity(const std::string& filename)
+	{
+		std::ifstream ifs(filename, std::ios::binary);
+		char magic[sizeof(binary::cMagic)];
+		if(!ifs.read(magic, sizeof(magic))) {
+			return false;
+		}
+		return std::memcmp(magic, binary::cMagic, sizeof(magic)) == 0;
+	}
+
+	void SaveBinaryDensity(const std::string& filename, const Eigen::MatrixXf& mat)
+	{
+		binary::Header header;
+		std::memcpy(header.magic, binary::cMagic, sizeof(header.magic));
+		header.version = binary::cVersion;
+		header.dtype = static_cast<uint32_t>(binary::DType::Float32);
+		header.width = mat.rows();
+		header.height = mat.cols();
+		header.checksum = binary::Checksum(mat.data(), mat.size());
+		std::ofstream ofs(filename, std::ios::binary);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(mat.data()), mat.size()*sizeof(float));
+		if(!ofs) {
+			throw std::runtime_error("ERROR: Could not write binary density file '" + filename + "'!");
+		}
+	}
+
+	Eigen::MatrixXf LoadBinaryDensity(const std::string& filename)
+	{
+		std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+		if(!ifs.is_open()) {
+			throw std::runtime_error("ERROR: Could not open binary density file '" + filename + "'!");
+		}
+		const std::size_t size = ifs.tellg();
+		binary::Header header;
+		ifs.seekg(0);
+		if(size < sizeof(header) || !ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+			throw std::runtime_error("ERROR: Binary density file '" + filename + "' is too small!");
+		}
+		const char* error = binary::CheckHeader(header, size - sizeof(header));
+		Eigen::MatrixXf mat;
+		if(!error) {
+			mat.resize(header.width, header.height);
+			if(!ifs.read(reinterpret_cast<char*>(mat.data()), mat.size()*sizeof(float))) {
+				error = "could not read values";
+			}
+			else if(binary::Checksum(mat.data(), mat.size()) != header.checksum) {
+				error = "checksum mismatch";
+			}
+		}
+		if(error) {
+			throw std::runtime_error("ERROR: Binary density file '" + filename + "': " + error + "!");
+		}
+		return mat;
+	}
+
+	MappedDensity::MappedDensity(const std::string& filename)
+	:	mapping_(0), size_(0), data_(0), width_(0), height_(0)
+	{
+		const int fd = open(filename.c_str(), O_RDONLY);
+		if(fd == -1) {
+			throw std::runtime_error("ERROR: Could not open binary density file '" + filename + "'!");
+		}
+		struct stat st;
+		if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(binary::Header)) {
+			close(fd);
+			throw std::runtime_error("ERROR: Binary density file '" + filename + "' is too small!");
+		}
+		size_ = st.st_size;
+		mapping_ = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(mapping_ == MAP_FAILED) {
+			mapping_ = 0;
+			throw std::runtime_error("ERROR: Could not map binary density file '" + filename + "'!");
+		}
+		// validate header and data
+		const binary::Header& header = *static_cast<const binary::Header*>(mapping_);
+		const char* error = binary::CheckHeader(header, size_ - sizeof(binary::Header));
+		if(!error) {
+			data_ = reinterpret_cast<const float*>(static_cast<const char*>(mapping_) + sizeof(binary::Header));
+			if(binary::Checksum(data_, static_cast<std::size_t>(header.width)*header.height) != header.checksum) {
+				error = "checksum mismatch";
+			}
+		}
+		if(error) {
+			munmap(mapping_, size_);
+			throw std::runtime_error("ERROR: Binary density file '" + filename + "': " + error + "!");
+		}
+		width_ = header.width;
+		height_ = header.height;
+	}
+
+	MappedDensity::~MappedDensity()
+	{
+		if(mapping_) {
+			munmap(mapping_, size_);
+		}
+	}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * BinaryDensity.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef INCLUDED_DENSITY_BINARYDENSITY_HPP
+#define INCLUDED_DENSITY_BINARYDENSITY_HPP
+
+#include <Eigen/Dense>
+#include <string>
+#include <cstdint>
+
+namespace density
+{
+
+	/** Binary density file format
+	 * A 32 byte header followed by width*height float values in column-major order
+	 * (i.e. row by row of the image) with native byte order.
+	 */
+	namespace binary
+	{
+		constexpr char cMagic[8] = {'D','A','S','P','D','E','N','S'};
+
+		constexpr uint32_t cVersion = 1;
+
+		/** Data type of values */
+		enum class DType : uint32_t
+		{
+			Float32 = 1
+		};
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t dtype;
+			uint32_t width;
+			uint32_t height;
+			/** Checksum of the values (see Checksum) */
+			uint64_t checksum;
+		};
+
+		static_assert(sizeof(Header) == 32, "Binary density header must have 32 bytes");
+
+		/** FNV-1a hash over the 32 bit words of the data */
+		uint64_t Checksum(const float* data, std::size_t n);
+	}
+
+	/** Tests if a file starts with the header of a binary density file */
+	bool IsBinaryDensity(const std::string& filename);
+
+	/** Writes a density in the binary density file format */
+	void SaveBinaryDensity(const std::string& filename, const Eigen::MatrixXf& mat);
+
+	/** Reads a binary density file into a matrix
+	 * Throws std::runtime_error if the file can not be read or if the header or
+	 * checksum are invalid.
+	 */
+	Eigen::MatrixXf LoadBinaryDensity(const std::string& filename);
+
+	/** Read-only memory mapping of a binary density file
+	 * The values are used in place without copying. Use LoadBinaryDensity if a
+	 * copy of the values is needed anyway. Throws std::runtime_error if the
+	 * file can not be mapped or if the header or checksum are invalid.
+	 */
+	class MappedDensity
+	{
+	public:
+		explicit MappedDensity(const std::string& filename);
+
+		~MappedDensity();
+
+		MappedDensity(const MappedDensity&) = delete;
+		MappedDensity& operator=(const MappedDensity&) = delete;
+
+		unsigned int width() const {
+			return width_;
+		}
+
+		unsigned int height() const {
+			return height_;
+		}
+
+		Eigen::Map<const Eigen::MatrixXf> matrix() const {
+			return Eigen::Map<const Eigen::MatrixXf>(data_, width_, height_);
+		}
+
+	private:
+		void* mapping_;
+		std::size_t size_;
+		const float* data_;
+		unsigned int width_;
+		unsigned int height_;
+	};
+
+}
+
+#endif
@@ -1,7 +1,11 @@
 #include "PointDensity.hpp"
+#include "BinaryDensity.hpp"
 #include <slimage/image.hpp>
 #include <slimage/opencv.hpp>
 #include <slimage/io.hpp>
+#include <Danvil/Tools/Parallel.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 
@@ -10,6 +14,9 @@ namespace density
 
 	Eigen::MatrixXf LoadDensity(const std::string& filename)
 	{
+		if(IsBinaryDensity(filename)) {
+			return LoadBinaryDensity(filename);
+		}
 		std::string stem = filename.substr(filename.size()-4, 4);
 		bool is_image = (stem == ".png" || stem == ".jpg");
 		if(is_image) {
@@ -71,6 +78,10 @@ namespace density
 
 	void SaveDensity(const std::string& filename, const Eigen::MatrixXf& mat)
 	{
+		if(filename.size() >= 5 && filename.substr(filename.size()-5, 5) == ".dens") {
+			SaveBinaryDensity(filename, mat);
+			return;
+		}
 		bool is_image =
 			filename.substr(filename.size()-3, 3) == ".png" ||
 			filename.substr(filename.size()-3, 3) == ".jpg";
@@ -94,8 +105,72 @@ namespace density
 		}
 	}
 
-	template<typename T, typename Fx, typename Fy>
-	Eigen::MatrixXf PointDensityImpl(const std::vector<T>& seeds, const Eigen::MatrixXf& target, Fx fx, Fy fy)
+	namespace
+	{
+		/** Size of tiles in which seeds are splatted in parallel */
+		constexpr int cTileSize = 64;
+
+		/** Kernel of one seed and its clipped window [xmin,xmax]x[ymin,ymax] */
+		struct SeedKernel
+		{
+			float x, y;
+			float rho_soft;
+			int xmin, xmax, ymin, ymax;
+		};
+
+		/** Private accumulation buffer of a tile which covers the kernel windows of all seeds of the tile */
+		struct TileBuffer
+		{
+			int x0, y0;
+			Eigen::MatrixXf values;
+		};
+
+		/** Adds the kernel of a seed to a buffer with origin (x0,y0) */
+		void SplatKernel(const SeedKernel& k, int x0, int y0, Eigen::MatrixXf& buffer)
+		{
+			// kernel is evaluated for 8 pixels of a row at once
+			float arg[8];
+			float delta[8];
+			for(int yi=k.ymin; yi<=k.ymax; yi++) {
+				const float dy = static_cast<float>(yi) - k.y;
+				float* dst = &buffer(0, yi - y0) - x0;
+				for(int xi=k.xmin; xi<=k.xmax; xi+=8) {
+					const int n = std::min(8, k.xmax + 1 - xi);
+					for(int i=0; i<8; i++) {
+						const float dx = static_cast<float>(xi + i) - k.x;
+						arg[i] = k.rho_soft*(dx*dx + dy*dy);
+					}
+					KernelSquare8(arg, delta);
+					for(int i=0; i<n; i++) {
+						dst[xi + i] += k.rho_soft * delta[i];
+					}
+				}
+			}
+		}
+
+		/** Adds the kernel of a seed to a buffer with origin (x0,y0) using that the kernel is separable
+		 * exp(-pi*rho*(dx^2 + dy^2)) = exp(-pi*rho*dx^2) * exp(-pi*rho*dy^2)
+		 * Only 2R kernel values are evaluated and each row is a vectorized multiply-add.
+		 */
+		void SplatKernelSeparable(const SeedKernel& k, int x0, int y0, Eigen::MatrixXf& buffer)
+		{
+			const int nx = k.xmax - k.xmin + 1;
+			const int ny = k.ymax - k.ymin + 1;
+			Eigen::VectorXf wx(nx);
+			for(int i=0; i<nx; i++) {
+				const float dx = static_cast<float>(k.xmin + i) - k.x;
+				wx[i] = std::exp(-cPi*k.rho_soft*dx*dx);
+			}
+			for(int i=0; i<ny; i++) {
+				const float dy = static_cast<float>(k.ymin + i) - k.y;
+				const float wy = k.rho_soft * std::exp(-cPi*k.rho_soft*dy*dy);
+				buffer.col(k.ymin + i - y0).segment(k.xmin - x0, nx) += wy * wx;
+			}
+		}
+	}
+
+	template<typename T, typename Fx, typename Fy, typename Splat>
+	Eigen::MatrixXf PointDensityImpl(const std::vector<T>& seeds, const Eigen::MatrixXf& target, Fx fx, Fy fy, Splat splat)
 	{
 		// radius of box in which to average cluster density
 		constexpr int RHO_R = 3;
@@ -104,9 +179,11 @@ namespace density
 		constexpr float cRange = 1.3886f;
 		const int rows = target.rows();
 		const int cols = target.cols();
-		// range of kernel s.t. 99.9% of mass is covered
-		Eigen::MatrixXf density = Eigen::MatrixXf::Zero(rows, cols);
-		for(const T& s : seeds) {
+		// kernel of each seed
+		std::vector<SeedKernel> kernels(seeds.size());
+		std::vector<unsigned char> is_valid(seeds.size(), 0);
+		Danvil::ParallelFor(seeds.size(), [&](std::size_t k) {
+			const T& s = seeds[k];
 			const int sx = std::round(fx(s));
 			const int sy = std::round(fy(s));
 			// compute point density as average over a box
@@ -125,32 +202,91 @@ namespace density
 				}
 			}
 			if(rho_sum == 0.0f || rho_num == 0) {
-				continue;
+				return;
 			}
 			const float rho = rho_sum / static_cast<float>(rho_num);
 			// seed corresponds to a kernel at position (x,y)
 			// with sigma = 1/sqrt(pi*rho)
 			// i.e. 1/sigma^2 = pi*rho
 			// factor pi is already compensated in kernel
-			const float sxf = fx(s);
-			const float syf = fy(s);
-			const float rho_soft = cMagicSoftener * rho;
+			SeedKernel& kernel = kernels[k];
+			kernel.x = fx(s);
+			kernel.y = fy(s);
+			kernel.rho_soft = cMagicSoftener * rho;
 			// kernel influence range
-			const int R = static_cast<int>(std::ceil(cRange / std::sqrt(rho_soft)));
-			const int xmin = std::max<int>(sx - R, 0);
-			const int xmax = std::min<int>(sx + R, int(rows) - 1);
-			const int ymin = std::max<int>(sy - R, 0);
-			const int ymax = std::min<int>(sy + R, int(cols) - 1);
-			for(int yi=ymin; yi<=ymax; yi++) {
-				for(int xi=xmin; xi<=xmax; xi++) {
-					float dx = static_cast<float>(xi) - sxf;
-					float dy = static_cast<float>(yi) - syf;
-					float d2 = dx*dx + dy*dy;
-					float delta = rho_soft * KernelSquare(rho_soft*d2);
-					density(xi, yi) += delta;
+			const int R = static_cast<int>(std::ceil(cRange / std::sqrt(kernel.rho_soft)));
+			kernel.xmin = std::max<int>(sx - R, 0);
+			kernel.xmax = std::min<int>(sx + R, int(rows) - 1);
+			kernel.ymin = std::max<int>(sy - R, 0);
+			kernel.ymax = std::min<int>(sy + R, int(cols) - 1);
+			is_valid[k] = 1;
+		});
+		// bucket seeds into tiles by the center of their window
+		const int tiles_x = (rows + cTileSize - 1) / cTileSize;
+		const int tiles_y = (cols + cTileSize - 1) / cTileSize;
+		const int num_tiles = tiles_x * tiles_y;
+		std::vector<std::vector<unsigned int>> tile_seeds(num_tiles);
+		for(unsigned int k=0; k<seeds.size(); k++) {
+			const SeedKernel& kernel = kernels[k];
+			if(!is_valid[k] || kernel.xmin > kernel.xmax || kernel.ymin > kernel.ymax) {
+				continue;
+			}
+			const int tx = ((kernel.xmin + kernel.xmax) / 2) / cTileSize;
+			const int ty = ((kernel.ymin + kernel.ymax) / 2) / cTileSize;
+			tile_seeds[tx + tiles_x*ty].push_back(k);
+		}
+		// splat seeds of each tile into a private buffer
+		std::vector<TileBuffer> buffers(num_tiles);
+		Danvil::ParallelFor(num_tiles, [&](std::size_t t) {
+			const std::vector<unsigned int>& ids = tile_seeds[t];
+			if(ids.empty()) {
+				return;
+			}
+			int xmin = rows, xmax = -1, ymin = cols, ymax = -1;
+			for(unsigned int k : ids) {
+				xmin = std::min(xmin, kernels[k].xmin);
+				xmax = std::max(xmax, kernels[k].xmax);
+				ymin = std::min(ymin, kernels[k].ymin);
+				ymax = std::max(ymax, kernels[k].ymax);
+			}
+			TileBuffer& b = buffers[t];
+			b.x0 = xmin;
+			b.y0 = ymin;
+			b.values = Eigen::MatrixXf::Zero(xmax - xmin + 1, ymax - ymin + 1);
+			for(unsigned int k : ids) {
+				splat(kernels[k], b.x0, b.y0, b.values);
+			}
+		}, 1);
+		// merge buffers into the result tile by tile (in a fixed order for deterministic results)
+		std::vector<std::vector<unsigned int>> tile_sources(num_tiles);
+		for(int t=0; t<num_tiles; t++) {
+			const TileBuffer& b = buffers[t];
+			if(b.values.size() == 0) {
+				continue;
+			}
+			const int tx1 = (b.x0 + b.values.rows() - 1) / cTileSize;
+			const int ty1 = (b.y0 + b.values.cols() - 1) / cTileSize;
+			for(int ty=b.y0/cTileSize; ty<=ty1; ty++) {
+				for(int tx=b.x0/cTileSize; tx<=tx1; tx++) {
+					tile_sources[tx + tiles_x*ty].push_back(t);
 				}
 			}
 		}
+		Eigen::MatrixXf density = Eigen::MatrixXf::Zero(rows, cols);
+		Danvil::ParallelFor(num_tiles, [&](std::size_t t) {
+			const int x0 = (t % tiles_x) * cTileSize;
+			const int y0 = (t / tiles_x) * cTileSize;
+			const int x1 = std::min(x0 + cTileSize, rows);
+			const int y1 = std::min(y0 + cTileSize, cols);
+			for(unsigned int s : tile_sources[t]) {
+				const TileBuffer& b = buffers[s];
+				const int bx0 = std::max(x0, b.x0);
+				const int bx1 = std::min<int>(x1, b.x0 + b.values.rows());
+				const int by0 = std::max(y0, b.y0);
+				const int by1 = std::min<int>(y1, b.y0 + b.values.cols());
+				density.block(bx0, by0, bx1 - bx0, by1 - by0) += b.values.block(bx0 - b.x0, by0 - b.y0, bx1 - bx0, by1 - by0);
+			}
+		}, 1);
 		{
 			const float* psrc = target.data();
 			const float* psrc_end = psrc + rows*cols;
@@ -168,7 +304,17 @@ namespace density
 	{
 		return PointDensityImpl(seeds, target,
 				[](const Eigen::Vector2f& s) { return s[0]; },
-				[](const Eigen::Vector2f& s) { return s[1]; }
+				[](const Eigen::Vector2f& s) { return s[1]; },
+				&SplatKernel
+		);
+	}
+
+	Eigen::MatrixXf PointDensitySeparable(const std::vector<Eigen::Vector2f>& seeds, const Eigen::MatrixXf& target)
+	{
+		return PointDensityImpl(seeds, target,
+				[](const Eigen::Vector2f& s) { return s[0]; },
+				[](const Eigen::Vector2f& s) { return s[1]; },
+				&SplatKernelSeparable
 		);
 	}
 
@@ -1,29 +1,26 @@
 #ifndef INCLUDED_PDS_DENSITY_HPP
 #define INCLUDED_PDS_DENSITY_HPP
 
-#include <Danvil/Tools/FunctionCache.h>
+#include <Danvil/Tools/FastExp.h>
 #include <Eigen/Dense>
 #include <vector>
 
 namespace density
 {
 
-	/** Loads a density function from a file (image or tsv) */
+	/** Loads a density function from a file (binary, image or tsv)
+	 * Binary density files are detected by their header, see BinaryDensity.hpp.
+	 */
 	Eigen::MatrixXf LoadDensity(const std::string& fn);
 
-	/** Saves a density function to a file (image or tsv) */
+	/** Saves a density function to a file (binary for extension .dens, image or tsv) */
 	void SaveDensity(const std::string& fn, const Eigen::MatrixXf& m);
 
 	constexpr float KernelRange = 2.5f;
 	constexpr float cPi = 3.141592654f;
 
-	inline float KernelImpl(float d) {
-		return std::exp(-cPi*d*d);
-	}
-
 	inline float Kernel(float d) {
-		static Danvil::FunctionCache<float,1> cache(0.0f, KernelRange, &KernelImpl);
-		return cache(std::abs(d));
+		return Danvil::ExpNeg(cPi*d*d);
 	}
 
 	inline float KernelSquareImpl(float d2) {
@@ -31,13 +28,28 @@ namespace density
 	}
 
 	inline float KernelSquare(float d2) {
-		static Danvil::FunctionCache<float,1> cache(0.0f, KernelRange*KernelRange, &KernelSquareImpl);
-		return cache(d2);
+		return Danvil::ExpNeg(cPi*d2);
 	}
 
-	/** Computes density approximation for a set of points  */
+	/** Computes y[i] = KernelSquare(d2[i]) for i=0..7 */
+	inline void KernelSquare8(const float* d2, float* y) {
+		float x[8];
+		for(unsigned int i=0; i<8; i++) {
+			x[i] = cPi*d2[i];
+		}
+		Danvil::ExpNeg8(x, y);
+	}
+
+	/** Computes density approximation for a set of points
+	 * Seeds are splatted in parallel into private buffers of image tiles which are merged afterwards.
+	 */
 	Eigen::MatrixXf PointDensity(const std::vector<Eigen::Vector2f>& points, const Eigen::MatrixXf& density);
 
+	/** Like PointDensity, but evaluates the kernel exactly as a product of two 1D kernels
+	 * Needs 2R instead of R^2 kernel evaluations per seed and does not use the kernel cache.
+	 */
+	Eigen::MatrixXf PointDensitySeparable(const std::vector<Eigen::Vector2f>& points, const Eigen::MatrixXf& density);
+
 }
 
 #endif
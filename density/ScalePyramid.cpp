@@ -2,10 +2,87 @@
 #include <Danvil/Tools/MoreMath.h>
 #include <boost/assert.hpp>
 #include <iostream>
+#include <cstring>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 //----------------------------------------------------------------------------//
 namespace density {
 //----------------------------------------------------------------------------//
 
+namespace
+{
+	/** Sums 2x2 cells of the columns a and b of length n into dst
+	 * b may be null for the last column of an image with odd height.
+	 */
+	void ReduceColumns(const float* a, const float* b, unsigned int n, float* dst)
+	{
+		const unsigned int n_pairs = n / 2;
+		unsigned int i = 0;
+		if(b) {
+#ifdef __SSE2__
+			for(; i+4<=n_pairs; i+=4) {
+				const __m128 s0 = _mm_add_ps(_mm_loadu_ps(a + 2*i), _mm_loadu_ps(b + 2*i));
+				const __m128 s1 = _mm_add_ps(_mm_loadu_ps(a + 2*i + 4), _mm_loadu_ps(b + 2*i + 4));
+				const __m128 even = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2,0,2,0));
+				const __m128 odd = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3,1,3,1));
+				_mm_storeu_ps(dst + i, _mm_add_ps(even, odd));
+			}
+#endif
+			for(; i<n_pairs; i++) {
+				dst[i] = (a[2*i] + b[2*i]) + (a[2*i+1] + b[2*i+1]);
+			}
+			if(n % 2 == 1) {
+				dst[n_pairs] = a[n-1] + b[n-1];
+			}
+		}
+		else {
+			for(; i<n_pairs; i++) {
+				dst[i] = a[2*i] + a[2*i+1];
+			}
+			if(n % 2 == 1) {
+				dst[n_pairs] = a[n-1];
+			}
+		}
+	}
+}
+
+ScalePyramid::ScalePyramid(const Eigen::MatrixXf& img)
+{
+	// level sizes and offsets
+	std::size_t total = 0;
+	unsigned int w = img.rows();
+	unsigned int h = img.cols();
+	while(true) {
+		width_.push_back(w);
+		height_.push_back(h);
+		offset_.push_back(total);
+		total += static_cast<std::size_t>(w) * static_cast<std::size_t>(h);
+		if(w <= 1 && h <= 1) {
+			break;
+		}
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	data_.resize(total);
+	// level 0 is the image
+	if(!data_.empty()) {
+		std::memcpy(data_.data(), img.data(), img.size()*sizeof(float));
+	}
+	// reduce 2x2 cells
+	for(unsigned int l=1; l<numLevels(); l++) {
+		const unsigned int ws = width_[l-1];
+		const unsigned int hs = height_[l-1];
+		const float* src = data_.data() + offset_[l-1];
+		float* dst = data_.data() + offset_[l];
+		for(unsigned int y=0; y<height_[l]; y++) {
+			const float* a = src + 2*y*ws;
+			const float* b = (2*y + 1 < hs) ? a + ws : 0;
+			ReduceColumns(a, b, ws, dst + y*width_[l]);
+		}
+	}
+}
+
 Eigen::MatrixXf SumMipMapWithBlackBorder(const Eigen::MatrixXf& img_big)
 {
 	size_t w_big = img_big.rows();
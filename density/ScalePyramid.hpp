@@ -13,10 +13,77 @@
 #include <stdexcept>
 #include <vector>
 #include <tuple>
+#include <algorithm>
 #include <cassert>
 
 namespace density {
 
+/** Sum pyramid of an image with all levels stored in one contiguous buffer
+ * Level 0 is the image and each element of level l+1 is the sum of a 2x2 cell of level l.
+ * Level sizes are rounded up instead of padding the image to a power of two square,
+ * so cells at the right and bottom border may only partially cover the image.
+ * Missing pixels count as 0. The last level has size 1x1.
+ */
+class ScalePyramid
+{
+public:
+	ScalePyramid() {}
+
+	explicit ScalePyramid(const Eigen::MatrixXf& img);
+
+	unsigned int numLevels() const {
+		return width_.size();
+	}
+
+	unsigned int width(unsigned int l) const {
+		return width_[l];
+	}
+
+	unsigned int height(unsigned int l) const {
+		return height_[l];
+	}
+
+	Eigen::Map<Eigen::MatrixXf> level(unsigned int l) {
+		return Eigen::Map<Eigen::MatrixXf>(data_.data() + offset_[l], width_[l], height_[l]);
+	}
+
+	Eigen::Map<const Eigen::MatrixXf> level(unsigned int l) const {
+		return Eigen::Map<const Eigen::MatrixXf>(data_.data() + offset_[l], width_[l], height_[l]);
+	}
+
+	bool valid(unsigned int l, unsigned int x, unsigned int y) const {
+		return x < width_[l] && y < height_[l];
+	}
+
+	/** Value of an element or 0 if the element is outside of the level */
+	float operator()(unsigned int l, unsigned int x, unsigned int y) const {
+		return valid(l, x, y) ? data_[offset_[l] + x + y*width_[l]] : 0.0f;
+	}
+
+	float& at(unsigned int l, unsigned int x, unsigned int y) {
+		assert(valid(l, x, y));
+		return data_[offset_[l] + x + y*width_[l]];
+	}
+
+	/** Number of image pixels in x direction covered by the element (l,x,.) */
+	unsigned int cellWidth(unsigned int l, unsigned int x) const {
+		const unsigned int x0 = x << l;
+		return (x0 >= width_[0]) ? 0 : std::min(1u << l, width_[0] - x0);
+	}
+
+	/** Number of image pixels in y direction covered by the element (l,.,y) */
+	unsigned int cellHeight(unsigned int l, unsigned int y) const {
+		const unsigned int y0 = y << l;
+		return (y0 >= height_[0]) ? 0 : std::min(1u << l, height_[0] - y0);
+	}
+
+private:
+	std::vector<unsigned int> width_;
+	std::vector<unsigned int> height_;
+	std::vector<std::size_t> offset_;
+	std::vector<float> data_;
+};
+
 Eigen::MatrixXf SumMipMapWithBlackBorder(const Eigen::MatrixXf& img_big);
 
 template<unsigned int Q>
@@ -1,14 +1,37 @@
 #include "Smooth.hpp"
 #include "PointDensity.hpp"
+#include <Danvil/Tools/Parallel.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
 
 namespace density
 {
 
+	namespace
+	{
+		/** Computes w[d] = KernelSquare(rho*d*d) for d=0..R in blocks of 8 */
+		void KernelWeights(float rho, int R, std::vector<float>& arg, std::vector<float>& w)
+		{
+			const int n = ((R + 8) / 8) * 8;
+			arg.resize(n);
+			w.resize(n);
+			for(int d=0; d<n; d++) {
+				arg[d] = rho * static_cast<float>(d*d);
+			}
+			for(int d=0; d<n; d+=8) {
+				KernelSquare8(&arg[d], &w[d]);
+			}
+		}
+	}
+
 	Eigen::MatrixXf DensityAdaptiveSmoothBase(const Eigen::MatrixXf& src)
 	{
 		const int width = src.rows();
 		const int height = src.cols();
 		Eigen::MatrixXf result(width, height);
+		std::vector<float> arg, wk;
 		for(int i=0; i<height; i++) {
 			for(int j=0; j<width; j++) {
 				const float rho = src(j,i);
@@ -21,14 +44,13 @@ namespace density
 				const int xmax = std::min<int>(j + R, width - 1);
 				const int ymin = std::max<int>(i - R, 0);
 				const int ymax = std::min<int>(i + R, height - 1);
+				// the kernel is separable: KernelSquare(rho*(dx^2+dy^2)) = w[|dx|]*w[|dy|]
+				KernelWeights(rho, R, arg, wk);
 				float a_sum = 0.0f;
 				float w_sum = 0.0f;
 				for(int ki=ymin; ki<=ymax; ki++) {
 					for(int kj=xmin; kj<=xmax; kj++) {
-						int dx = kj - j;
-						int dy = ki - i;
-						int d2 = dx*dx + dy*dy;
-						float w = KernelSquare(rho*static_cast<float>(d2));
+						float w = wk[std::abs(kj - j)] * wk[std::abs(ki - i)];
 						a_sum += w * src(kj,ki);
 						w_sum += w;
 					}
@@ -44,6 +66,7 @@ namespace density
 		const int width = src.rows();
 		const int height = src.cols();
 		Eigen::MatrixXf result1(width, height);
+		std::vector<float> arg, wk;
 		for(int i=0; i<height; i++) {
 			for(int j=0; j<width; j++) {
 				const float rho = src(j,i);
@@ -54,11 +77,11 @@ namespace density
 				const int R = static_cast<int>(std::ceil(KernelRange / std::sqrt(rho)));
 				const int xmin = std::max<int>(j - R, 0);
 				const int xmax = std::min<int>(j + R, width - 1);
+				KernelWeights(rho, R, arg, wk);
 				float a_sum = 0.0f;
 				float w_sum = 0.0f;
 				for(int kj=xmin; kj<=xmax; kj++) {
-					int dx = kj - j;
-					float w = KernelSquare(rho*static_cast<float>(dx*dx));
+					float w = wk[std::abs(kj - j)];
 					float v = src(kj,i);
 					if(v > 0.0f) {
 						a_sum += w * v;
@@ -79,11 +102,11 @@ namespace density
 				const int R = static_cast<int>(std::ceil(KernelRange / std::sqrt(rho)));
 				const int ymin = std::max<int>(i - R, 0);
 				const int ymax = std::min<int>(i + R, height - 1);
+				KernelWeights(rho, R, arg, wk);
 				float a_sum = 0.0f;
 				float w_sum = 0.0f;
 				for(int ki=ymin; ki<=ymax; ki++) {
-					int dy = ki - i;
-					float w = KernelSquare(rho*static_cast<float>(dy*dy));
+					float w = wk[std::abs(ki - i)];
 					float v = result1(j,ki);
 					if(v > 0.0f) {
 						a_sum += w * v;
@@ -96,6 +119,97 @@ namespace density
 		return result2;
 	}
 
+	namespace
+	{
+		/** Number of box filters which approximate the Gaussian */
+		constexpr int cNumBoxPasses = 3;
+
+		/** Summed-area tables of values and of the number of non-zero values
+		 * Entry (j,i) holds the sum over all pixels (x,y) with x<j and y<i.
+		 */
+		struct SummedAreaTable
+		{
+			Eigen::MatrixXd sum;
+			Eigen::MatrixXd num;
+
+			SummedAreaTable(const Eigen::MatrixXf& src) {
+				const int width = src.rows();
+				const int height = src.cols();
+				sum = Eigen::MatrixXd::Zero(width + 1, height + 1);
+				num = Eigen::MatrixXd::Zero(width + 1, height + 1);
+				// prefix sums of each row
+				Danvil::ParallelFor(height, [this, &src, width](std::size_t i) {
+					double a = 0.0;
+					double n = 0.0;
+					for(int j=0; j<width; j++) {
+						const float v = src(j,i);
+						if(v > 0.0f) {
+							a += v;
+							n += 1.0;
+						}
+						sum(j+1,i+1) = a;
+						num(j+1,i+1) = n;
+					}
+				}, 16);
+				// accumulate rows
+				for(int i=1; i<height; i++) {
+					sum.col(i+1) += sum.col(i);
+					num.col(i+1) += num.col(i);
+				}
+			}
+
+			/** Mean over non-zero values in the box [xmin,xmax[ x [ymin,ymax[ */
+			void box(int xmin, int xmax, int ymin, int ymax, double& a, double& n) const {
+				a = sum(xmax,ymax) - sum(xmin,ymax) - sum(xmax,ymin) + sum(xmin,ymin);
+				n = num(xmax,ymax) - num(xmin,ymax) - num(xmax,ymin) + num(xmin,ymin);
+			}
+		};
+
+		/** Box filter with variable radius which uses the density rho for the radius
+		 * A box with radius r has variance r(r+1)/3 and each pass needs variance var_pass.
+		 * The filter blends boxes with radius r and r+1 such that the variance matches exactly.
+		 */
+		Eigen::MatrixXf AdaptiveBoxPass(const Eigen::MatrixXf& src, const Eigen::MatrixXf& rho)
+		{
+			const int width = src.rows();
+			const int height = src.cols();
+			const SummedAreaTable sat(src);
+			Eigen::MatrixXf result(width, height);
+			Danvil::ParallelFor(height, [&](std::size_t i) {
+				for(int j=0; j<width; j++) {
+					const float rho_ji = rho(j,i);
+					if(rho_ji == 0.0f || src(j,i) == 0.0f) {
+						result(j,i) = 0.0f;
+						continue;
+					}
+					// kernel exp(-pi*rho*d^2) has variance 1/(2*pi*rho)
+					const double var_pass = 1.0 / (2.0 * cPi * cNumBoxPasses * rho_ji);
+					const int r = static_cast<int>(std::floor(0.5*(std::sqrt(1.0 + 12.0*var_pass) - 1.0)));
+					const double var0 = static_cast<double>(r*(r+1)) / 3.0;
+					const double var1 = static_cast<double>((r+1)*(r+2)) / 3.0;
+					const double t = std::min(1.0, std::max(0.0, (var_pass - var0) / (var1 - var0)));
+					double a0, n0, a1, n1;
+					sat.box(std::max(j - r, 0), std::min(j + r + 1, width), std::max<int>(i - r, 0), std::min<int>(i + r + 1, height), a0, n0);
+					sat.box(std::max(j - r - 1, 0), std::min(j + r + 2, width), std::max<int>(i - r - 1, 0), std::min<int>(i + r + 2, height), a1, n1);
+					// weights of the two boxes are normalized by their area
+					const double w0 = (1.0 - t) / static_cast<double>((2*r+1)*(2*r+1));
+					const double w1 = t / static_cast<double>((2*r+3)*(2*r+3));
+					result(j,i) = static_cast<float>((w0*a0 + w1*a1) / (w0*n0 + w1*n1));
+				}
+			}, 8);
+			return result;
+		}
+	}
+
+	Eigen::MatrixXf DensityAdaptiveSmoothBox(const Eigen::MatrixXf& src)
+	{
+		Eigen::MatrixXf result = src;
+		for(int k=0; k<cNumBoxPasses; k++) {
+			result = AdaptiveBoxPass(result, src);
+		}
+		return result;
+	}
+
 	Eigen::MatrixXf DensityAdaptiveSmooth(const Eigen::MatrixXf& src)
 	{
 		//return DensityAdaptiveSmoothBase(src);
@@ -6,6 +6,18 @@
 namespace density
 {
 
+	/** Gaussian blur with density-adaptive radius evaluating the full 2D kernel */
+	Eigen::MatrixXf DensityAdaptiveSmoothBase(const Eigen::MatrixXf& d);
+
+	/** Gaussian blur with density-adaptive radius evaluating two 1D kernels */
+	Eigen::MatrixXf DensityAdaptiveSmoothSeparated(const Eigen::MatrixXf& d);
+
+	/** Gaussian blur with density-adaptive radius approximated by a cascade of box filters
+	 * Each box is evaluated in constant time with a summed-area table, so the runtime
+	 * does not depend on the kernel radius.
+	 */
+	Eigen::MatrixXf DensityAdaptiveSmoothBox(const Eigen::MatrixXf& d);
+
 	/** Gaussian blur using density-adaptive radius as kernel radius */
 	Eigen::MatrixXf DensityAdaptiveSmooth(const Eigen::MatrixXf& d);
 
@@ -1,16 +1,113 @@
 #include <density/PointDensity.hpp>
 #include <density/Smooth.hpp>
+#include <density/BinaryDensity.hpp>
+#include <Danvil/Tools/FastExp.h>
+#include <Danvil/Tools/FunctionCache.h>
 #include <boost/program_options.hpp>
 #include <boost/timer/timer.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <functional>
+#include <map>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <cmath>
 
+/** Loads a density and returns the time in milliseconds */
+double MeasureLoad(const std::string& fn, Eigen::MatrixXf& result)
+{
+	const auto t0 = std::chrono::steady_clock::now();
+	result = density::LoadDensity(fn);
+	const auto t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double,std::milli>(t1 - t0).count();
+}
+
+std::size_t FileSize(const std::string& fn)
+{
+	std::ifstream ifs(fn, std::ios::binary | std::ios::ate);
+	return ifs.tellg();
+}
+
+/** Measures time per value and maximal error against std::exp for arguments in [0,x_max] */
+template<typename F>
+void BenchmarkKernel(const std::string& name, float x_max, float (*reference)(float), F f)
+{
+	constexpr std::size_t cNumValues = 1 << 20;
+	constexpr unsigned int cRepetitions = 5;
+	std::vector<float> x(cNumValues);
+	std::vector<float> y(cNumValues);
+	for(std::size_t i=0; i<cNumValues; i++) {
+		// values are permuted to prevent unrealistic caching of table lookups
+		x[i] = x_max * static_cast<float>((i*7919) % cNumValues) / static_cast<float>(cNumValues - 1);
+	}
+	double best = std::numeric_limits<double>::max();
+	for(unsigned int k=0; k<cRepetitions; k++) {
+		const auto t0 = std::chrono::steady_clock::now();
+		f(x.data(), y.data(), cNumValues);
+		const auto t1 = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double,std::nano>(t1 - t0).count() / static_cast<double>(cNumValues));
+	}
+	double max_abs = 0.0;
+	double max_rel = 0.0;
+	for(std::size_t i=0; i<cNumValues; i++) {
+		const double expected = reference(x[i]);
+		const double delta = std::abs(static_cast<double>(y[i]) - expected);
+		max_abs = std::max(max_abs, delta);
+		max_rel = std::max(max_rel, delta / expected);
+	}
+	std::cout << name << ": " << best << " ns/value, max abs error=" << max_abs << ", max rel error=" << max_rel << std::endl;
+}
+
+float ExpNegReference(float x)
+{
+	return std::exp(-static_cast<double>(x));
+}
+
+float KernelSquareReference(float d2)
+{
+	return std::exp(-static_cast<double>(density::cPi)*static_cast<double>(d2));
+}
+
+/** Kernel approximations in the ranges which are used by affinities and density kernels */
+void BenchmarkKernels()
+{
+	// exp(-x) for spectral affinities
+	constexpr float cExpRange = 9.7f;
+	const Danvil::FunctionCache<float,0> exp_table(0.0f, cExpRange, [](float x) { return std::exp(-x); });
+	std::cout << "exp(-x) for x in [0," << cExpRange << "]" << std::endl;
+	BenchmarkKernel("  std::exp", cExpRange, &ExpNegReference,
+		[](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = std::exp(-x[i]); });
+	BenchmarkKernel("  table (previous ExpNegFunctionCache)", cExpRange, &ExpNegReference,
+		[&exp_table](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = exp_table(x[i]); });
+	BenchmarkKernel("  ExpNeg", cExpRange, &ExpNegReference,
+		[](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = Danvil::ExpNeg(x[i]); });
+	BenchmarkKernel("  ExpNeg8", cExpRange, &ExpNegReference,
+		[](const float* x, float* y, std::size_t n) { Danvil::ExpNeg(x, y, n); });
+	// KernelSquare for density kernels
+	constexpr float cKernelRange = density::KernelRange*density::KernelRange;
+	const Danvil::FunctionCache<float,1> kernel_table(0.0f, cKernelRange, &density::KernelSquareImpl);
+	std::cout << "KernelSquare(d2) for d2 in [0," << cKernelRange << "]" << std::endl;
+	BenchmarkKernel("  std::exp", cKernelRange, &KernelSquareReference,
+		[](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = density::KernelSquareImpl(x[i]); });
+	BenchmarkKernel("  table (previous KernelSquare)", cKernelRange, &KernelSquareReference,
+		[&kernel_table](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = kernel_table(x[i]); });
+	BenchmarkKernel("  KernelSquare", cKernelRange, &KernelSquareReference,
+		[](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i<n; i++) y[i] = density::KernelSquare(x[i]); });
+	BenchmarkKernel("  KernelSquare8", cKernelRange, &KernelSquareReference,
+		[](const float* x, float* y, std::size_t n) { for(std::size_t i=0; i+8<=n; i+=8) density::KernelSquare8(x + i, y + i); });
+}
+
 int main(int argc, char** argv)
 {
 	std::string p_in = "";
 	std::string p_out = "out.tsv";
+	std::string p_method = "separated";
+	bool p_compare = false;
+	bool p_benchmark_io = false;
+	bool p_benchmark_kernel = false;
 
 	namespace po = boost::program_options;
 	po::options_description desc;
@@ -18,6 +115,10 @@ int main(int argc, char** argv)
 		("help", "produce help message")
 		("density", po::value(&p_in), "filename for input density")
 		("out", po::value(&p_out), "filename for smoothed output density")
+		("method", po::value(&p_method), "smoothing method: base, separated or box")
+		("compare", po::value(&p_compare)->zero_tokens(), "runs all methods and reports time and error relative to base")
+		("benchmark_io", po::value(&p_benchmark_io)->zero_tokens(), "compares load throughput of text and binary density files")
+		("benchmark_kernel", po::value(&p_benchmark_kernel)->zero_tokens(), "measures speed and error of kernel approximations and exits")
 	;
 
 	po::variables_map vm;
@@ -28,13 +129,62 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	Eigen::MatrixXf rho = density::LoadDensity(p_in);
-	std::cout << "Loaded density dim=" << rho.rows() << "x" << rho.cols() << ", sum=" << rho.sum() << "." << std::endl;
+	if(p_benchmark_kernel) {
+		BenchmarkKernels();
+		return 0;
+	}
+
+	Eigen::MatrixXf rho;
+	const double load_ms = MeasureLoad(p_in, rho);
+	std::cout << "Loaded density dim=" << rho.rows() << "x" << rho.cols() << ", sum=" << rho.sum() << " in " << load_ms << " ms." << std::endl;
+
+	if(p_benchmark_io) {
+		const std::string fn_text = p_out + ".io_test.tsv";
+		const std::string fn_binary = p_out + ".io_test.dens";
+		density::SaveDensity(fn_text, rho);
+		density::SaveDensity(fn_binary, rho);
+		for(const std::string& fn : {fn_text, fn_binary}) {
+			Eigen::MatrixXf loaded;
+			const double ms = MeasureLoad(fn, loaded);
+			const double mb = static_cast<double>(FileSize(fn)) / (1024.0*1024.0);
+			std::cout << (density::IsBinaryDensity(fn) ? "binary" : "text") << ": " << ms << " ms, "
+				<< mb / (ms / 1000.0) << " MB/s, "
+				<< static_cast<double>(loaded.size()) / (ms / 1000.0) / 1e6 << " Mvalues/s"
+				<< ", max difference=" << (loaded - rho).cwiseAbs().maxCoeff() << std::endl;
+			std::remove(fn.c_str());
+		}
+	}
+
+	const std::map<std::string,std::function<Eigen::MatrixXf(const Eigen::MatrixXf&)>> methods = {
+		{"base", &density::DensityAdaptiveSmoothBase},
+		{"separated", &density::DensityAdaptiveSmoothSeparated},
+		{"box", &density::DensityAdaptiveSmoothBox}
+	};
+	if(methods.find(p_method) == methods.end()) {
+		std::cerr << "ERROR: Unknown smoothing method '" << p_method << "'!" << std::endl;
+		return 1;
+	}
+
+	if(p_compare) {
+		std::map<std::string,Eigen::MatrixXf> results;
+		for(const auto& m : methods) {
+			std::cout << m.first << ": ";
+			boost::timer::auto_cpu_timer t;
+			results[m.first] = m.second(rho);
+		}
+		const Eigen::MatrixXf& reference = results["base"];
+		const float reference_sum = reference.cwiseAbs().sum();
+		for(const auto& r : results) {
+			const Eigen::MatrixXf delta = (r.second - reference).cwiseAbs();
+			std::cout << r.first << ": max error=" << delta.maxCoeff()
+				<< ", relative L1 error=" << delta.sum() / reference_sum << std::endl;
+		}
+	}
 
 	Eigen::MatrixXf result;
 	{
 		boost::timer::auto_cpu_timer t;
-		result = density::DensityAdaptiveSmooth(rho);
+		result = methods.at(p_method)(rho);
 	}
 
 	density::SaveDensity(p_out, result);
@@ -8,7 +8,7 @@
 #ifndef DASP_SPECTRAL_COMMON_HPP
 #define DASP_SPECTRAL_COMMON_HPP
 
-#include <boost/graph/adjacency_list.hpp>
+#include "CsrGraph.hpp"
 #include <Eigen/Dense>
 #include <vector>
 
@@ -39,13 +39,15 @@ namespace graphseg
 			unsigned int dim;
 			std::vector<SparseEntry> entries;
 		};
+
+		/** A symmetric dense matrix of which only the lower triangle is referenced
+		 * Binds to matrices and to maps of preallocated buffers without copying.
+		 */
+		typedef Eigen::Ref<const Eigen::MatrixXf> DenseMatrix;
 	}
 	
 	/** A simple weighted undirected graph */
-	typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS,
-			boost::no_property,
-			float
-	> SpectralGraph;
+	typedef CsrGraph<boost::no_property, float> SpectralGraph;
 
 }
 
@@ -0,0 +1,435 @@
+/*
+ * CsrGraph.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef GRAPHSEG_CSRGRAPH_HPP
+#define GRAPHSEG_CSRGRAPH_HPP
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <boost/pending/property.hpp>
+#include <type_traits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace graphseg
+{
+
+	/** Topology of an undirected graph in compressed sparse row layout
+	 * Edges are numbered 0..num_edges-1 in the order in which they are given.
+	 * The incident edges of vertex v are incident[offset[v]..offset[v+1][.
+	 * A self loop is listed once in the incidence list of its vertex.
+	 * Topologies are immutable and shared between graphs.
+	 */
+	struct CsrTopology
+	{
+		unsigned int num_vertices;
+		std::vector<unsigned int> edge_source;
+		std::vector<unsigned int> edge_target;
+		std::vector<unsigned int> offset;
+		std::vector<unsigned int> incident;
+
+		unsigned int numEdges() const {
+			return edge_source.size();
+		}
+	};
+
+	/** Creates a graph topology from a list of undirected edges
+	 * Edge k of the topology is edges[k].
+	 */
+	inline std::shared_ptr<const CsrTopology> CreateCsrTopology(unsigned int num_vertices, const std::vector<std::pair<unsigned int,unsigned int>>& edges)
+	{
+		std::shared_ptr<CsrTopology> t = std::make_shared<CsrTopology>();
+		t->num_vertices = num_vertices;
+		const unsigned int num_edges = edges.size();
+		t->edge_source.resize(num_edges);
+		t->edge_target.resize(num_edges);
+		// count vertex degrees
+		t->offset.resize(num_vertices + 1, 0);
+		for(unsigned int k=0; k<num_edges; k++) {
+			const unsigned int a = edges[k].first;
+			const unsigned int b = edges[k].second;
+			t->edge_source[k] = a;
+			t->edge_target[k] = b;
+			t->offset[a+1] ++;
+			if(a != b) {
+				t->offset[b+1] ++;
+			}
+		}
+		for(unsigned int i=0; i<num_vertices; i++) {
+			t->offset[i+1] += t->offset[i];
+		}
+		// fill incidence lists in edge order
+		t->incident.resize(t->offset[num_vertices]);
+		std::vector<unsigned int> pos(t->offset.begin(), t->offset.end() - 1);
+		for(unsigned int k=0; k<num_edges; k++) {
+			const unsigned int a = edges[k].first;
+			const unsigned int b = edges[k].second;
+			t->incident[pos[a]++] = k;
+			if(a != b) {
+				t->incident[pos[b]++] = k;
+			}
+		}
+		return t;
+	}
+
+	/** Creates a graph topology without edges */
+	inline std::shared_ptr<const CsrTopology> CreateCsrTopology(unsigned int num_vertices)
+	{
+		return CreateCsrTopology(num_vertices, {});
+	}
+
+	/** Edge of a CsrGraph
+	 * The edge index identifies the edge in all graphs sharing a topology.
+	 */
+	struct CsrEdge
+	{
+		unsigned int source;
+		unsigned int target;
+		unsigned int index;
+
+		bool operator==(const CsrEdge& e) const { return index == e.index; }
+		bool operator!=(const CsrEdge& e) const { return index != e.index; }
+		bool operator<(const CsrEdge& e) const { return index < e.index; }
+	};
+
+	namespace detail
+	{
+		struct CsrEdgeAt
+		{
+			typedef CsrEdge result_type;
+			const CsrTopology* t;
+			CsrEdge operator()(unsigned int k) const {
+				return CsrEdge{t->edge_source[k], t->edge_target[k], k};
+			}
+		};
+
+		struct CsrOutEdgeAt
+		{
+			typedef CsrEdge result_type;
+			const CsrTopology* t;
+			unsigned int v;
+			CsrEdge operator()(unsigned int i) const {
+				const unsigned int k = t->incident[i];
+				const unsigned int a = t->edge_source[k];
+				return CsrEdge{v, (a == v ? t->edge_target[k] : a), k};
+			}
+		};
+
+		struct CsrAdjacentAt
+		{
+			typedef unsigned int result_type;
+			const CsrTopology* t;
+			unsigned int v;
+			unsigned int operator()(unsigned int i) const {
+				const unsigned int k = t->incident[i];
+				const unsigned int a = t->edge_source[k];
+				return (a == v ? t->edge_target[k] : a);
+			}
+		};
+
+		/** Lvalue property map over a contiguous property array */
+		template<typename Key, typename T>
+		struct CsrPropertyMap
+		: public boost::put_get_helper<T&, CsrPropertyMap<Key,T>>
+		{
+			typedef Key key_type;
+			typedef typename std::remove_const<T>::type value_type;
+			typedef T& reference;
+			typedef boost::lvalue_property_map_tag category;
+
+			T* data;
+
+			CsrPropertyMap(T* p=0) : data(p) {}
+
+			T& operator[](const Key& key) const {
+				return data[IndexOf(key)];
+			}
+
+		private:
+			static unsigned int IndexOf(unsigned int v) { return v; }
+			static unsigned int IndexOf(const CsrEdge& e) { return e.index; }
+		};
+
+		struct CsrEdgeIndexMap
+		: public boost::put_get_helper<unsigned int, CsrEdgeIndexMap>
+		{
+			typedef CsrEdge key_type;
+			typedef unsigned int value_type;
+			typedef unsigned int reference;
+			typedef boost::readable_property_map_tag category;
+
+			unsigned int operator[](const CsrEdge& e) const {
+				return e.index;
+			}
+		};
+
+		struct csr_graph_traversal_category
+		: public virtual boost::incidence_graph_tag,
+		  public virtual boost::adjacency_graph_tag,
+		  public virtual boost::vertex_list_graph_tag,
+		  public virtual boost::edge_list_graph_tag
+		{};
+	}
+
+	/** An undirected graph with compressed sparse row topology
+	 * Vertex and edge properties are stored in contiguous arrays indexed by
+	 * vertex id and edge index. The topology can not be changed after
+	 * construction and is shared by copies and by graphs constructed from
+	 * another graph's topology, e.g. to attach new edge weights without copying
+	 * the graph structure.
+	 * Models the boost graph concepts IncidenceGraph, AdjacencyGraph,
+	 * VertexListGraph and EdgeListGraph with bundled properties.
+	 */
+	template<typename VertexProperty, typename EdgeProperty, typename GraphProperty=boost::no_property>
+	class CsrGraph
+	{
+	public:
+		typedef unsigned int vertex_descriptor;
+		typedef CsrEdge edge_descriptor;
+		typedef boost::undirected_tag directed_category;
+		typedef boost::allow_parallel_edge_tag edge_parallel_category;
+		typedef detail::csr_graph_traversal_category traversal_category;
+		typedef unsigned int vertices_size_type;
+		typedef unsigned int edges_size_type;
+		typedef unsigned int degree_size_type;
+		typedef boost::counting_iterator<unsigned int> vertex_iterator;
+		typedef boost::transform_iterator<detail::CsrEdgeAt, boost::counting_iterator<unsigned int>> edge_iterator;
+		typedef boost::transform_iterator<detail::CsrOutEdgeAt, boost::counting_iterator<unsigned int>> out_edge_iterator;
+		typedef boost::transform_iterator<detail::CsrAdjacentAt, boost::counting_iterator<unsigned int>> adjacency_iterator;
+		typedef VertexProperty vertex_bundled;
+		typedef EdgeProperty edge_bundled;
+		typedef GraphProperty graph_bundled;
+
+		static vertex_descriptor null_vertex() {
+			return static_cast<vertex_descriptor>(-1);
+		}
+
+		/** Graph with n vertices and no edges */
+		explicit CsrGraph(unsigned int n=0)
+		: CsrGraph(CreateCsrTopology(n)) {}
+
+		/** Graph with the given topology and default properties */
+		explicit CsrGraph(const std::shared_ptr<const CsrTopology>& topology)
+		: topology_(topology),
+		  vertex_properties_(topology->num_vertices),
+		  edge_properties_(topology->numEdges()) {}
+
+		/** Graph with the given topology and properties
+		 * Property arrays must have one element per vertex or edge.
+		 */
+		CsrGraph(const std::shared_ptr<const CsrTopology>& topology, std::vector<VertexProperty> vertex_properties, std::vector<EdgeProperty> edge_properties)
+		: topology_(topology),
+		  vertex_properties_(std::move(vertex_properties)),
+		  edge_properties_(std::move(edge_properties)) {}
+
+		const std::shared_ptr<const CsrTopology>& topology() const {
+			return topology_;
+		}
+
+		const std::vector<VertexProperty>& vertexProperties() const {
+			return vertex_properties_;
+		}
+
+		std::vector<VertexProperty>& vertexProperties() {
+			return vertex_properties_;
+		}
+
+		const std::vector<EdgeProperty>& edgeProperties() const {
+			return edge_properties_;
+		}
+
+		std::vector<EdgeProperty>& edgeProperties() {
+			return edge_properties_;
+		}
+
+		VertexProperty& operator[](vertex_descriptor v) {
+			return vertex_properties_[v];
+		}
+
+		const VertexProperty& operator[](vertex_descriptor v) const {
+			return vertex_properties_[v];
+		}
+
+		EdgeProperty& operator[](const edge_descriptor& e) {
+			return edge_properties_[e.index];
+		}
+
+		const EdgeProperty& operator[](const edge_descriptor& e) const {
+			return edge_properties_[e.index];
+		}
+
+		GraphProperty& operator[](boost::graph_bundle_t) {
+			return graph_property_;
+		}
+
+		const GraphProperty& operator[](boost::graph_bundle_t) const {
+			return graph_property_;
+		}
+
+	private:
+		std::shared_ptr<const CsrTopology> topology_;
+		std::vector<VertexProperty> vertex_properties_;
+		std::vector<EdgeProperty> edge_properties_;
+		GraphProperty graph_property_;
+	};
+
+}
+
+namespace boost
+{
+#define GRAPHSEG_CSR_TEMPLATE template<typename V, typename E, typename G>
+#define GRAPHSEG_CSR_GRAPH graphseg::CsrGraph<V,E,G>
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int num_vertices(const GRAPHSEG_CSR_GRAPH& g) {
+		return g.topology()->num_vertices;
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int num_edges(const GRAPHSEG_CSR_GRAPH& g) {
+		return g.topology()->numEdges();
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline std::pair<typename GRAPHSEG_CSR_GRAPH::vertex_iterator, typename GRAPHSEG_CSR_GRAPH::vertex_iterator>
+	vertices(const GRAPHSEG_CSR_GRAPH& g) {
+		typedef typename GRAPHSEG_CSR_GRAPH::vertex_iterator it_t;
+		return std::make_pair(it_t(0u), it_t(num_vertices(g)));
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline std::pair<typename GRAPHSEG_CSR_GRAPH::edge_iterator, typename GRAPHSEG_CSR_GRAPH::edge_iterator>
+	edges(const GRAPHSEG_CSR_GRAPH& g) {
+		typedef typename GRAPHSEG_CSR_GRAPH::edge_iterator it_t;
+		const graphseg::detail::CsrEdgeAt f{g.topology().get()};
+		return std::make_pair(
+			it_t(boost::counting_iterator<unsigned int>(0u), f),
+			it_t(boost::counting_iterator<unsigned int>(num_edges(g)), f));
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int source(const graphseg::CsrEdge& e, const GRAPHSEG_CSR_GRAPH&) {
+		return e.source;
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int target(const graphseg::CsrEdge& e, const GRAPHSEG_CSR_GRAPH&) {
+		return e.target;
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int out_degree(unsigned int v, const GRAPHSEG_CSR_GRAPH& g) {
+		const graphseg::CsrTopology& t = *g.topology();
+		return t.offset[v+1] - t.offset[v];
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline unsigned int degree(unsigned int v, const GRAPHSEG_CSR_GRAPH& g) {
+		return out_degree(v, g);
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline std::pair<typename GRAPHSEG_CSR_GRAPH::out_edge_iterator, typename GRAPHSEG_CSR_GRAPH::out_edge_iterator>
+	out_edges(unsigned int v, const GRAPHSEG_CSR_GRAPH& g) {
+		typedef typename GRAPHSEG_CSR_GRAPH::out_edge_iterator it_t;
+		const graphseg::CsrTopology& t = *g.topology();
+		const graphseg::detail::CsrOutEdgeAt f{&t, v};
+		return std::make_pair(
+			it_t(boost::counting_iterator<unsigned int>(t.offset[v]), f),
+			it_t(boost::counting_iterator<unsigned int>(t.offset[v+1]), f));
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline std::pair<typename GRAPHSEG_CSR_GRAPH::adjacency_iterator, typename GRAPHSEG_CSR_GRAPH::adjacency_iterator>
+	adjacent_vertices(unsigned int v, const GRAPHSEG_CSR_GRAPH& g) {
+		typedef typename GRAPHSEG_CSR_GRAPH::adjacency_iterator it_t;
+		const graphseg::CsrTopology& t = *g.topology();
+		const graphseg::detail::CsrAdjacentAt f{&t, v};
+		return std::make_pair(
+			it_t(boost::counting_iterator<unsigned int>(t.offset[v]), f),
+			it_t(boost::counting_iterator<unsigned int>(t.offset[v+1]), f));
+	}
+
+	/** Finds an edge between u and v (linear in the degree of u) */
+	GRAPHSEG_CSR_TEMPLATE
+	inline std::pair<graphseg::CsrEdge, bool> edge(unsigned int u, unsigned int v, const GRAPHSEG_CSR_GRAPH& g) {
+		for(auto it=out_edges(u, g); it.first!=it.second; ++it.first) {
+			const graphseg::CsrEdge e = *it.first;
+			if(e.target == v) {
+				return std::make_pair(e, true);
+			}
+		}
+		return std::make_pair(graphseg::CsrEdge{u, v, static_cast<unsigned int>(-1)}, false);
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	struct property_map<GRAPHSEG_CSR_GRAPH, vertex_index_t>
+	{
+		typedef typed_identity_property_map<unsigned int> type;
+		typedef type const_type;
+	};
+
+	GRAPHSEG_CSR_TEMPLATE
+	struct property_map<GRAPHSEG_CSR_GRAPH, edge_index_t>
+	{
+		typedef graphseg::detail::CsrEdgeIndexMap type;
+		typedef type const_type;
+	};
+
+	GRAPHSEG_CSR_TEMPLATE
+	struct property_map<GRAPHSEG_CSR_GRAPH, vertex_bundle_t>
+	{
+		typedef graphseg::detail::CsrPropertyMap<unsigned int, V> type;
+		typedef graphseg::detail::CsrPropertyMap<unsigned int, const V> const_type;
+	};
+
+	GRAPHSEG_CSR_TEMPLATE
+	struct property_map<GRAPHSEG_CSR_GRAPH, edge_bundle_t>
+	{
+		typedef graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, E> type;
+		typedef graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, const E> const_type;
+	};
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline typed_identity_property_map<unsigned int> get(vertex_index_t, const GRAPHSEG_CSR_GRAPH&) {
+		return typed_identity_property_map<unsigned int>();
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline graphseg::detail::CsrEdgeIndexMap get(edge_index_t, const GRAPHSEG_CSR_GRAPH&) {
+		return graphseg::detail::CsrEdgeIndexMap();
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline graphseg::detail::CsrPropertyMap<unsigned int, V> get(vertex_bundle_t, GRAPHSEG_CSR_GRAPH& g) {
+		return graphseg::detail::CsrPropertyMap<unsigned int, V>(g.vertexProperties().data());
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline graphseg::detail::CsrPropertyMap<unsigned int, const V> get(vertex_bundle_t, const GRAPHSEG_CSR_GRAPH& g) {
+		return graphseg::detail::CsrPropertyMap<unsigned int, const V>(g.vertexProperties().data());
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, E> get(edge_bundle_t, GRAPHSEG_CSR_GRAPH& g) {
+		return graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, E>(g.edgeProperties().data());
+	}
+
+	GRAPHSEG_CSR_TEMPLATE
+	inline graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, const E> get(edge_bundle_t, const GRAPHSEG_CSR_GRAPH& g) {
+		return graphseg::detail::CsrPropertyMap<graphseg::CsrEdge, const E>(g.edgeProperties().data());
+	}
+
+#undef GRAPHSEG_CSR_GRAPH
+#undef GRAPHSEG_CSR_TEMPLATE
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define INCLUDED_GRAPHSEG_IO_HPP_
 
 #include "as_range.hpp"
+#include <boost/graph/adjacency_list.hpp>
 #include <fstream>
 #include <stdexcept>
 
@@ -40,6 +41,7 @@ namespace graphseg
 	 * Expected file format:
 	 *   One line per edge
 	 *   Two integers per line giving vertex indices
+	 * Graph must support boost::add_edge (e.g. boost::adjacency_list).
 	 */
 	template<typename Graph>
 	void ReadEdges(const std::string& filename, Graph& graph)
@@ -59,6 +61,7 @@ namespace graphseg
 	 * Expected file format:
 	 *   One line per edge
 	 *   Two integers per line giving vertex indices and one float for the edge weight
+	 * Graph must support boost::add_edge (e.g. boost::adjacency_list).
 	 */
 	template<typename Graph, typename WeightMap>
 	void ReadEdges(const std::string& filename, Graph& graph, WeightMap weights)
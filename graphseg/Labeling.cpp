@@ -1,18 +1,44 @@
 #include "Labeling.hpp"
+#include <algorithm>
 
 namespace graphseg
 {
 
 void GraphLabeling::relabel()
 {
-	// find set of unique labels
-	std::set<int> unique_labels_set(labels.begin(), labels.end());
-	std::vector<int> unique_labels(unique_labels_set.begin(), unique_labels_set.end());
-	num_labels = unique_labels.size();
-	// create new labeling
-	for(int& x : labels) {
-		auto it = std::find(unique_labels.begin(), unique_labels.end(), x);
-		x = it - unique_labels.begin();
+	if(labels.empty()) {
+		num_labels = 0;
+		return;
+	}
+	const auto minmax = std::minmax_element(labels.begin(), labels.end());
+	const int label_min = *minmax.first;
+	const std::size_t range = static_cast<std::size_t>(static_cast<long long>(*minmax.second) - static_cast<long long>(label_min)) + 1;
+	if(range <= 4*labels.size() + 1024) {
+		// dense label range: lookup table with the new label for each old label
+		std::vector<int> lut(range, -1);
+		for(int x : labels) {
+			lut[x - label_min] = 0;
+		}
+		int n = 0;
+		for(int& y : lut) {
+			if(y == 0) {
+				y = n++;
+			}
+		}
+		num_labels = n;
+		for(int& x : labels) {
+			x = lut[x - label_min];
+		}
+	}
+	else {
+		// sparse label range: sorted unique labels and binary search
+		std::vector<int> unique_labels(labels);
+		std::sort(unique_labels.begin(), unique_labels.end());
+		unique_labels.erase(std::unique(unique_labels.begin(), unique_labels.end()), unique_labels.end());
+		num_labels = unique_labels.size();
+		for(int& x : labels) {
+			x = std::lower_bound(unique_labels.begin(), unique_labels.end(), x) - unique_labels.begin();
+		}
 	}
 }
 
@@ -24,4 +50,29 @@ GraphLabeling GraphLabeling::CreateClean(const std::vector<int>& labels)
 	return x;
 }
 
+unsigned int UcmHierarchy::numSegments(float threshold) const
+{
+	// every merge with a smaller weight reduces the number of segments by one
+	const unsigned int num_merges = std::lower_bound(merge_weight.begin(), merge_weight.end(), threshold) - merge_weight.begin();
+	return num_vertices - num_merges;
+}
+
+GraphLabeling UcmHierarchy::labeling(float threshold) const
+{
+	// propagate labels top-down through all merges below the threshold
+	const int num_nodes = parent.size();
+	std::vector<int> node_segment(num_nodes);
+	for(int i=num_nodes-1; i>=0; i--) {
+		const int p = parent[i];
+		if(p >= 0 && merge_weight[p - num_vertices] < threshold) {
+			node_segment[i] = node_segment[p];
+		}
+		else {
+			node_segment[i] = node_label[i];
+		}
+	}
+	node_segment.resize(num_vertices);
+	return GraphLabeling::CreateClean(node_segment);
+}
+
 }
@@ -10,10 +10,14 @@
 
 #include "Common.hpp"
 #include "as_range.hpp"
-#include <boost/graph/adjacency_list.hpp>
+#include "UnionFind.hpp"
 #include <boost/graph/connected_components.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
 #include <vector>
 #include <iostream>
+#include <limits>
 
 namespace graphseg
 {
@@ -43,6 +47,36 @@ namespace graphseg
 	template<typename Graph>
 	GraphLabeling ComputeSegmentLabels_UCM(const Graph& graph, float threshold);
 
+	/** Merge hierarchy (dendrogram) of the UCM algorithm
+	 * Nodes 0..N-1 are the graph vertices and node N+k is the k-th merge of two
+	 * segments in order of increasing edge weight. Parents are always created
+	 * after their children. The labeling for a threshold is extracted in O(N)
+	 * and is identical to ComputeSegmentLabels_UCM.
+	 */
+	struct UcmHierarchy
+	{
+		unsigned int num_vertices;
+
+		/** parent of each node or -1 for top level segments */
+		std::vector<int> parent;
+
+		/** label of the segment of each node (as used by the UCM algorithm) */
+		std::vector<int> node_label;
+
+		/** weight of the edge which caused merge k (increasing) */
+		std::vector<float> merge_weight;
+
+		/** Number of segments for a threshold */
+		unsigned int numSegments(float threshold) const;
+
+		/** Segments for a threshold i.e. all merges with weight smaller than threshold are applied */
+		GraphLabeling labeling(float threshold) const;
+	};
+
+	/** Computes the UCM merge hierarchy for all edges with weight smaller than max_weight */
+	template<typename Graph>
+	UcmHierarchy ComputeUcmHierarchy(const Graph& graph, float max_weight=std::numeric_limits<float>::infinity());
+
 	namespace ComputeSegmentLabelsStrategies
 	{
 		enum type {
@@ -70,14 +104,15 @@ namespace graphseg
 	GraphLabeling ComputeSegmentLabels_ConnectedComponents(const WeightedGraph& graph, float threshold)
 	{
 		// create a graph will all edges with costs >= threshold
-		SpectralGraph cropped(boost::num_vertices(graph));
+		std::vector<std::pair<unsigned int,unsigned int>> cropped_edges;
 		for(auto eid : as_range(boost::edges(graph))) {
 			float weight = graph[eid];
 			// take only edges with weight < threshold
 			if(weight <= threshold) {
-				boost::add_edge(boost::source(eid, graph), boost::target(eid, graph), cropped);
+				cropped_edges.push_back(std::make_pair(boost::source(eid, graph), boost::target(eid, graph)));
 			}
 		}
+		SpectralGraph cropped(CreateCsrTopology(boost::num_vertices(graph), cropped_edges));
 		// compute connected components
 		std::vector<int> cluster_labels(boost::num_vertices(cropped));
 		unsigned int num_labels = boost::connected_components(cropped, &cluster_labels[0]);
@@ -86,12 +121,16 @@ namespace graphseg
 	}
 
 	template<typename WeightedGraph>
-	GraphLabeling ComputeSegmentLabels_UCM(const WeightedGraph& graph, float threshold)
+	UcmHierarchy ComputeUcmHierarchy(const WeightedGraph& graph, float max_weight)
 	{
+		const unsigned int num_vertices = boost::num_vertices(graph);
+		UcmHierarchy h;
+		h.num_vertices = num_vertices;
+		h.parent.assign(num_vertices, -1);
 		// every superpixel is one region
-		std::vector<int> cluster_labels(boost::num_vertices(graph));
-		for(unsigned int i=0; i<cluster_labels.size(); i++) {
-			cluster_labels[i] = i;
+		h.node_label.resize(num_vertices);
+		for(unsigned int i=0; i<num_vertices; i++) {
+			h.node_label[i] = i;
 		}
 		// get edge data
 		struct Edge {
@@ -99,6 +138,7 @@ namespace graphseg
 			float weight;
 		};
 		std::vector<Edge> edges;
+		edges.reserve(boost::num_edges(graph));
 		for(auto eid : as_range(boost::edges(graph))) {
 			edges.push_back(Edge{
 				static_cast<unsigned int>(boost::source(eid, graph)),
@@ -109,26 +149,39 @@ namespace graphseg
 		// sort edges by weight
 		std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y){ return x.weight < y.weight; });
 		// cut one edge after another and merge segments
-		for(unsigned int k=0; k<edges.size(); k++) {
-			if(edges[k].weight >= threshold) {
+		// the hierarchy node of each union-find root
+		UnionFind sets(num_vertices);
+		std::vector<unsigned int> root_node(num_vertices);
+		for(unsigned int i=0; i<num_vertices; i++) {
+			root_node[i] = i;
+		}
+		for(const Edge& e : edges) {
+			if(e.weight >= max_weight) {
 				break;
 			}
-			// join segments connected by edge
-			int l_old = cluster_labels[edges[k].a];
-			int l_new = cluster_labels[edges[k].b];
-			std::replace(cluster_labels.begin(), cluster_labels.end(), l_old, l_new);
-	#ifdef SEGS_DBG_SHOWGUI
-			if(k % 10 == 0) {
-				std::cout << "Removed edge with weight " << edges[k].cost << std::endl;
-				// show ucm
-				relabel();
-				slimage::Image3ub vis = computeLabelImage(clusters);
-				slimage::gui::Show("ucm", vis);
+			const unsigned int ra = sets.find(e.a);
+			const unsigned int rb = sets.find(e.b);
+			if(ra == rb) {
+				continue;
 			}
-	#endif
+			// join segments connected by edge (the segment keeps the label of b)
+			const unsigned int node = h.parent.size();
+			const unsigned int node_a = root_node[ra];
+			const unsigned int node_b = root_node[rb];
+			h.parent[node_a] = node;
+			h.parent[node_b] = node;
+			h.parent.push_back(-1);
+			h.node_label.push_back(h.node_label[node_b]);
+			h.merge_weight.push_back(e.weight);
+			root_node[sets.uniteRoots(ra, rb)] = node;
 		}
-		// create continuous labels
-		return GraphLabeling::CreateClean(cluster_labels);
+		return h;
+	}
+
+	template<typename WeightedGraph>
+	GraphLabeling ComputeSegmentLabels_UCM(const WeightedGraph& graph, float threshold)
+	{
+		return ComputeUcmHierarchy(graph, threshold).labeling(threshold);
 	}
 
 	namespace impl
@@ -168,15 +221,79 @@ namespace graphseg
 			return v_labels;
 		}
 
-		inline
-		void MergeLabels(std::vector<int>& labels, int a, int b) {
-			// keep the smaller label (this is the potentially supervised label)
-			if(a < b) {
-				std::swap(a, b);
+		/** Vertices order[begin..end[ which have the same label and sublabel */
+		struct LabelGroup
+		{
+			int label;
+			int sublabel;
+			unsigned int begin, end;
+
+			unsigned int size() const {
+				return end - begin;
 			}
-			// join segments connected by edge
-			std::replace(labels.begin(), labels.end(), a, b);
+		};
+
+		/** Groups vertices which are sorted by label and sublabel */
+		template<typename L1, typename L2>
+		std::vector<LabelGroup> GroupVertices(const std::vector<unsigned int>& order, const std::vector<L1>& labels, const std::vector<L2>& sublabels)
+		{
+			std::vector<LabelGroup> groups;
+			for(unsigned int k=0; k<order.size(); k++) {
+				const int label = labels[order[k]];
+				const int sublabel = sublabels[order[k]];
+				if(groups.empty() || groups.back().label != label || groups.back().sublabel != sublabel) {
+					groups.push_back(LabelGroup{label, sublabel, k, k});
+				}
+				groups.back().end = k + 1;
+			}
+			return groups;
 		}
+
+		/** Segments of the supervised UCM algorithms
+		 * Union-find over vertices with the segment label stored at each root.
+		 * Labels up to the supervised threshold are supervised. Merged segments
+		 * keep the smaller label which is the potentially supervised label.
+		 */
+		class SupervisedSegments
+		{
+		public:
+			SupervisedSegments(std::vector<int> labels, int label_supervised_threshold)
+			:	sets_(labels.size()), label_(std::move(labels)), label_supervised_threshold_(label_supervised_threshold) {}
+
+			/** Label of the segment containing vertex v */
+			int label(unsigned int v) {
+				return label_[sets_.find(v)];
+			}
+
+			bool isSupervised(int label) const {
+				return label <= label_supervised_threshold_;
+			}
+
+			/** Merges the segments containing vertices a and b */
+			void merge(unsigned int a, unsigned int b) {
+				const unsigned int ra = sets_.find(a);
+				const unsigned int rb = sets_.find(b);
+				if(ra == rb) {
+					return;
+				}
+				const int label = std::min(label_[ra], label_[rb]);
+				label_[sets_.uniteRoots(ra, rb)] = label;
+			}
+
+			/** Segment label for each vertex */
+			std::vector<int> labels() {
+				std::vector<int> result(label_.size());
+				for(unsigned int i=0; i<result.size(); i++) {
+					result[i] = label(i);
+				}
+				return result;
+			}
+
+		private:
+			UnionFind sets_;
+			std::vector<int> label_;
+			int label_supervised_threshold_;
+		};
 	}
 
 	/** Supervised labeling
@@ -193,7 +310,8 @@ namespace graphseg
 	{
 		// find supervised maximal label and give unique labels to unsupervised vertices
 		int label_supervised_threshold;
-		std::vector<int> cluster_labels = impl::PrepareLabels(graph, vertex_label_map, &label_supervised_threshold);
+		std::vector<int> initial_labels = impl::PrepareLabels(graph, vertex_label_map, &label_supervised_threshold);
+		impl::SupervisedSegments segments(std::move(initial_labels), label_supervised_threshold);
 		// get all edges with a weight smaller than the threshold
 		typedef impl::Edge Edge;
 		std::vector<Edge> edges;
@@ -213,25 +331,25 @@ namespace graphseg
 		// cut one edge after another and merge labels
 		for(const Edge& edge : edges) {
 			// get cluster labels
-			const int label_a = cluster_labels[edge.a];
-			const int label_b = cluster_labels[edge.b];
+			const int label_a = segments.label(edge.a);
+			const int label_b = segments.label(edge.b);
 			if(label_a == label_b) {
 				// clusters are already part of the same segment -> nothing to do
 				continue;
 			}
 			// check if cluster segments are supervised
-			const bool is_supervised_a = (label_a <= label_supervised_threshold);
-			const bool is_supervised_b = (label_b <= label_supervised_threshold);
+			const bool is_supervised_a = segments.isSupervised(label_a);
+			const bool is_supervised_b = segments.isSupervised(label_b);
 			// do not merge if both clusters are supervised
 			if(is_supervised_a && is_supervised_b) {
 				continue;
 			}
 			// merge labels
-			impl::MergeLabels(cluster_labels, label_a, label_b);
+			segments.merge(edge.a, edge.b);
 		}
 
 		// return raw labels
-		return cluster_labels;
+		return segments.labels();
 	}
 
 	namespace impl
@@ -259,7 +377,8 @@ namespace graphseg
 	{
 		// find supervised maximal label and give unique labels to unsupervised vertices
 		int label_supervised_threshold;
-		std::vector<int> cluster_labels = impl::PrepareLabels(graph, vertex_label_map, &label_supervised_threshold);
+		std::vector<int> initial_labels = impl::PrepareLabels(graph, vertex_label_map, &label_supervised_threshold);
+		impl::SupervisedSegments segments(std::move(initial_labels), label_supervised_threshold);
 		// get all edges
 		typedef impl::Edge Edge;
 		std::vector<Edge> edges;
@@ -278,10 +397,10 @@ namespace graphseg
 		// cut one edge after another and merge clusters into segments
 		for(const Edge& edge : edges) {
 			// get edge data
-			int& label_a = cluster_labels[edge.a];
-			int& label_b = cluster_labels[edge.b];
-			const bool is_supervised_a = (label_a <= label_supervised_threshold);
-			const bool is_supervised_b = (label_b <= label_supervised_threshold);
+			const int label_a = segments.label(edge.a);
+			const int label_b = segments.label(edge.b);
+			const bool is_supervised_a = segments.isSupervised(label_a);
+			const bool is_supervised_b = segments.isSupervised(label_b);
 			const float edge_weight = edge.weight;
 			// check low weight
 			if(edge_weight < th_low) {
@@ -291,7 +410,7 @@ namespace graphseg
 				// merge labels now only if not both are supervised
 				// when merging supervised labels we need to consider more ...
 				if(!(is_supervised_a && is_supervised_b)) {
-					impl::MergeLabels(cluster_labels, label_a, label_b);
+					segments.merge(edge.a, edge.b);
 				}
 			}
 			// check normal weight
@@ -301,7 +420,7 @@ namespace graphseg
 					merged_edges.push_back(edge);
 					if(dbg) dbg->normal_merge.push_back(edge);
 					if(label_a != label_b) {
-						impl::MergeLabels(cluster_labels, label_a, label_b);
+						segments.merge(edge.a, edge.b);
 					}
 				}
 				else {
@@ -323,75 +442,102 @@ namespace graphseg
 				if(dbg) dbg->no_merge.push_back(edge);
 			}
 		}
+		std::vector<int> cluster_labels = segments.labels();
 		// compute label for new clusters
 		int label_max = *std::max_element(cluster_labels.begin(), cluster_labels.end());
 		label_max = std::max(label_max, label_supervised_threshold);
 		// construct a graph with all merged edges
-		SpectralGraph cropped(boost::num_vertices(graph));
+		std::vector<std::pair<unsigned int,unsigned int>> cropped_edges;
+		std::vector<float> cropped_weights;
 		for(const Edge& e : merged_edges) {
-			auto p = boost::add_edge(e.a, e.b, cropped);
-			cropped[p.first] = e.weight;
+			cropped_edges.push_back(std::make_pair(e.a, e.b));
+			cropped_weights.push_back(e.weight);
 		}
+		SpectralGraph cropped(CreateCsrTopology(boost::num_vertices(graph), cropped_edges),
+			std::vector<boost::no_property>(boost::num_vertices(graph)), std::move(cropped_weights));
 		// compute connected components
 		std::vector<int> cluster_labels_components(boost::num_vertices(cropped));
 		unsigned int num_labels = boost::connected_components(cropped, &cluster_labels_components[0]);
 		// std::cout << "CC# = " << num_labels << std::endl;
+		// vertices sorted by label and component
+		const unsigned int num_vertices = cluster_labels.size();
+		std::vector<unsigned int> order(num_vertices);
+		for(unsigned int i=0; i<num_vertices; i++) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&cluster_labels, &cluster_labels_components](unsigned int x, unsigned int y) {
+			return std::make_pair(cluster_labels[x], cluster_labels_components[x]) < std::make_pair(cluster_labels[y], cluster_labels_components[y]);
+		});
 		// check if two components have the same label index
-		std::map<int, std::map<unsigned int, unsigned int>> label_component_count;
-		for(unsigned int i=0; i<cluster_labels.size(); i++) {
-			int label = cluster_labels[i];
-			unsigned int cmp_id = cluster_labels_components[i];
-			label_component_count[label][cmp_id] ++;
+		// each label keeps the component with most vertices and other components get a new label
+		std::vector<impl::LabelGroup> groups = impl::GroupVertices(order, cluster_labels, cluster_labels_components);
+		for(std::size_t g0=0; g0<groups.size(); ) {
+			std::size_t g1 = g0 + 1;
+			while(g1 < groups.size() && groups[g1].label == groups[g0].label) {
+				g1++;
+			}
+			if(g1 - g0 > 1) {
+				std::size_t g_max = g0;
+				for(std::size_t g=g0; g<g1; g++) {
+					if(groups[g].size() >= groups[g_max].size()) {
+						g_max = g;
+					}
+				}
+				for(std::size_t g=g0; g<g1; g++) {
+					if(g != g_max) {
+						const int label_new = ++label_max;
+						for(unsigned int k=groups[g].begin; k<groups[g].end; k++) {
+							cluster_labels[order[k]] = label_new;
+						}
+					}
+				}
+			}
+			g0 = g1;
 		}
-		for(auto p : label_component_count) {
-			if(p.second.size() > 1) {
-				// std::cout << "Label " << p.first << ": " << std::endl;
-				// std::cout << "\tcmp\tcnt" << std::endl;
-				unsigned int max_cmp = 0;
+		// check if one component contains more than one label
+		std::sort(order.begin(), order.end(), [&cluster_labels, &cluster_labels_components](unsigned int x, unsigned int y) {
+			return std::make_pair(cluster_labels_components[x], cluster_labels[x]) < std::make_pair(cluster_labels_components[y], cluster_labels[y]);
+		});
+		groups = impl::GroupVertices(order, cluster_labels_components, cluster_labels);
+		// every label is now used by only one component, so labels of a component
+		// can be merged independently of other components
+		std::vector<int> merged;
+		for(std::size_t g0=0; g0<groups.size(); ) {
+			std::size_t g1 = g0 + 1;
+			while(g1 < groups.size() && groups[g1].label == groups[g0].label) {
+				g1++;
+			}
+			if(g1 - g0 > 1) {
+				int max_label = 0;
 				unsigned int max_num = 0;
-				for(auto q : p.second) {
-					if(q.second >= max_num) {
-						max_cmp = q.first;
-						max_num = q.second;
+				for(std::size_t g=g0; g<g1; g++) {
+					if(groups[g].size() >= max_num) {
+						max_label = groups[g].sublabel;
+						max_num = groups[g].size();
 					}
 				}
-				std::map<unsigned int, int> label_remap;
-				for(auto q : p.second) {
-					if(q.first != max_cmp) {
-						label_remap[q.first] = ++label_max;
-					}
-					else {
-						label_remap[q.first] = p.first;
+				// merge each label with max_label in order of increasing labels
+				// (the larger label of two merged labels is replaced by the smaller one)
+				merged.resize(g1 - g0);
+				for(std::size_t g=g0; g<g1; g++) {
+					merged[g - g0] = groups[g].sublabel;
+				}
+				for(std::size_t g=g0; g<g1; g++) {
+					int a = groups[g].sublabel;
+					int b = max_label;
+					if(a < b) {
+						std::swap(a, b);
 					}
-					// std::cout << "\t" << q.first << "\t" << q.second << "\t->" << label_remap[q.first] << std::endl;
+					std::replace(merged.begin(), merged.end(), a, b);
 				}
-				for(unsigned int i=0; i<cluster_labels.size(); i++) {
-					if(cluster_labels[i] == p.first) {
-						cluster_labels[i] = label_remap[cluster_labels_components[i]];
+				for(std::size_t g=g0; g<g1; g++) {
+					for(unsigned int k=groups[g].begin; k<groups[g].end; k++) {
+						cluster_labels[order[k]] = merged[g - g0];
 					}
 				}
 			}
+			g0 = g1;
 		}
-		// check if one component contains more than one label
-		std::map<int, std::map<unsigned int, unsigned int>> component_label_count;
-		for(unsigned int i=0; i<cluster_labels.size(); i++) {
-			int label = cluster_labels[i];
-			unsigned int cmp_id = cluster_labels_components[i];
-			component_label_count[cmp_id][label] ++;
-		}
-		for(auto p : component_label_count) {			
-			unsigned int max_label = 0;
-			unsigned int max_num = 0;
-			for(auto q : p.second) {
-				if(q.second >= max_num) {
-					max_label = q.first;
-					max_num = q.second;
-				}
-			}
-			for(auto q : p.second) {
-				impl::MergeLabels(cluster_labels, q.first, max_label);
-			}
-		}		
 		// return raw labels
 		return cluster_labels;
 	}
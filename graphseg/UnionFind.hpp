@@ -0,0 +1,82 @@
+/*
+ * UnionFind.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef GRAPHSEG_UNIONFIND_HPP_
+#define GRAPHSEG_UNIONFIND_HPP_
+
+#include <vector>
+#include <utility>
+
+namespace graphseg
+{
+
+	/** Disjoint sets over the elements 0..n-1
+	 * Uses path compression and union by rank, so find and unite run in
+	 * amortized O(alpha(n)).
+	 */
+	class UnionFind
+	{
+	public:
+		UnionFind(unsigned int n=0) {
+			reset(n);
+		}
+
+		/** Puts every element into its own set */
+		void reset(unsigned int n) {
+			parent_.resize(n);
+			for(unsigned int i=0; i<n; i++) {
+				parent_[i] = i;
+			}
+			rank_.assign(n, 0);
+		}
+
+		unsigned int size() const {
+			return parent_.size();
+		}
+
+		/** Root element of the set containing x */
+		unsigned int find(unsigned int x) {
+			unsigned int root = x;
+			while(parent_[root] != root) {
+				root = parent_[root];
+			}
+			// path compression
+			while(parent_[x] != root) {
+				const unsigned int next = parent_[x];
+				parent_[x] = root;
+				x = next;
+			}
+			return root;
+		}
+
+		/** Joins the sets with roots ra and rb (ra != rb) and returns the new root */
+		unsigned int uniteRoots(unsigned int ra, unsigned int rb) {
+			if(rank_[ra] < rank_[rb]) {
+				std::swap(ra, rb);
+			}
+			parent_[rb] = ra;
+			if(rank_[ra] == rank_[rb]) {
+				rank_[ra] ++;
+			}
+			return ra;
+		}
+
+		/** Joins the sets containing a and b and returns the new root */
+		unsigned int unite(unsigned int a, unsigned int b) {
+			const unsigned int ra = find(a);
+			const unsigned int rb = find(b);
+			return (ra == rb) ? ra : uniteRoots(ra, rb);
+		}
+
+	private:
+		std::vector<unsigned int> parent_;
+		std::vector<unsigned char> rank_;
+	};
+
+}
+
+#endif
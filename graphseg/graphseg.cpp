@@ -20,50 +20,23 @@ namespace graphseg
 		return detail::graphseg_spectral(graph, boost::get(boost::edge_bundle, graph), num_ev, method);
 	}
 
-	SpectralGraph SolveMCL(const SpectralGraph& graph, float p, unsigned int iterations)
+	SpectralGraph SolveSpectral(const SpectralGraph& graph, unsigned int num_ev, SpectralMethod method,
+		const SpectralSubspace& initial_guess, SpectralSubspace* solution)
 	{
-		typedef Eigen::MatrixXf Mat;
-		std::cout << "input graph has " << boost::num_edges(graph) << " edges" << std::endl;
-		using namespace detail;
-		unsigned int dim = boost::num_vertices(graph);
-		// get adjacency matrix
-		std::cout << "adjacency matrix (size=" << dim << ")" << std::endl;
-		Mat W = Mat::Zero(dim, dim);
-		for(auto eid : as_range(boost::edges(graph))) {
-			unsigned int ea = boost::source(eid, graph);
-			unsigned int eb = boost::target(eid, graph);
-			float ew = graph[eid];
-			W(ea, eb) = ew;
-			W(eb, ea) = ew;
-		}
-		// perform MCL
-		for(int i=0; i<iterations; i++) {
-			std::cout << "MCL " << i << std::endl;
-			Mat M = (W*W).array().pow(p).matrix();
-			// column normalization
-			for(int i=0; i<dim; i++) {
-				const float total = M.col(i).sum();
-				if(total > 0.0f) {
-					const float scl = 1.0f / total;
-					M.col(i) *= scl;
-				}
-			}
-			W = M;
-		}
-		// create new graph with new edges
-		SpectralGraph result(dim);
-		for(int y=0; y<dim; y++) {
-			for(int x=0; x<dim; x++) {
-				float w = W(x,y);
-				if(w > 0.001f) {
-					bool ok;
-					SpectralGraph::edge_descriptor eid;
-					boost::tie(eid,ok) = boost::add_edge(x, y, result);
-					result[eid] = w;
-				}
+		return detail::graphseg_spectral(graph, boost::get(boost::edge_bundle, graph), num_ev, method, initial_guess, solution);
+	}
+
+	SpectralSubspace MapSpectralSubspace(const SpectralSubspace& previous, const std::vector<int>& correspondence)
+	{
+		const Eigen::MatrixXf& src = previous.eigenvectors;
+		SpectralSubspace result;
+		result.eigenvectors = Eigen::MatrixXf::Zero(correspondence.size(), src.cols());
+		for(unsigned int i=0; i<correspondence.size(); i++) {
+			const int j = correspondence[i];
+			if(0 <= j && j < src.rows()) {
+				result.eigenvectors.row(i) = src.row(j);
 			}
 		}
-		std::cout << "result graph has " << boost::num_edges(result) << " edges" << std::endl;
 		return result;
 	}
 
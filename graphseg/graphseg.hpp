@@ -9,6 +9,7 @@
 #define GRAPHSEG_HPP
 
 #include "Common.hpp"
+#include <string>
 
 namespace graphseg
 {
@@ -25,6 +26,10 @@ namespace graphseg
 		,ArpackPP
 #endif
 		,Lapack
+		,Lanczos
+		,Lobpcg
+		,Multilevel
+		,Auto // picks the solver expected to be fastest (see SelectSpectralMethod)
 #ifdef USE_SOLVER_MAGMA
 		,Magma
 #endif
@@ -33,10 +38,57 @@ namespace graphseg
 #endif
 	};
 
+	/** Eigenvectors of a spectral solution which can be used to start the next solve */
+	struct SpectralSubspace
+	{
+		/** Generalized eigenvectors (one column per eigenvector and one row per graph vertex) */
+		Eigen::MatrixXf eigenvectors;
+
+		/** Number of solver iterations (only for iterative solvers) */
+		unsigned int iterations = 0;
+	};
+
 	/** Applies spectral graph theory fu to a weighted, undirected graph */
 	SpectralGraph SolveSpectral(const SpectralGraph& graph, unsigned int num_ev, SpectralMethod method);
 
-	/** Like SolveSpectral, but with fastest available solver */
+	/** Like SolveSpectral, but starts iterative solvers with an initial guess
+	 * Currently only used by SpectralMethod::Lobpcg. The initial guess is typically
+	 * the solution of the previous frame mapped with MapSpectralSubspace.
+	 * If solution is not null the computed eigenvectors are written to it.
+	 */
+	SpectralGraph SolveSpectral(const SpectralGraph& graph, unsigned int num_ev, SpectralMethod method,
+		const SpectralSubspace& initial_guess, SpectralSubspace* solution);
+
+	/** Maps a subspace to the vertices of another graph
+	 * correspondence[i] is the vertex of the previous graph corresponding to vertex i
+	 * or -1 if there is none. Rows of vertices without correspondence are zero.
+	 */
+	SpectralSubspace MapSpectralSubspace(const SpectralSubspace& previous, const std::vector<int>& correspondence);
+
+	/** Selects the exact spectral solver which is expected to be fastest for a graph
+	 * Uses a cost model for each solver depending on the number of vertices,
+	 * edges and eigenvectors. The constants of the cost model are read from the file
+	 * given by the environment variable GRAPHSEG_SPECTRAL_CALIBRATION or else from
+	 * ~/.graphseg_spectral_calibration.
+	 * No benchmark is run automatically: the calibration file is only written by
+	 * CalibrateSpectralMethodSelection (or graphseg_cmd --mode calibrate). Without it
+	 * built-in constants measured for the Eigen, LAPACK, Lanczos and LOBPCG solvers
+	 * are used and the optional solvers (ARPACK, IETL, Magma) are never selected.
+	 */
+	SpectralMethod SelectSpectralMethod(unsigned int num_vertices, unsigned int num_edges, unsigned int num_ev);
+
+	/** Measures the cost model constants of SelectSpectralMethod on this machine
+	 * Takes a few seconds. The constants are used for all further selections and
+	 * are written to the calibration file.
+	 */
+	void CalibrateSpectralMethodSelection();
+
+	/** Name of a spectral solver */
+	std::string SpectralMethodName(SpectralMethod method);
+
+	/** Like SolveSpectral, but always with the dense Eigen solver
+	 * Use SpectralMethod::Auto to select the fastest solver for each graph.
+	 */
 	SpectralGraph SolveSpectral(const SpectralGraph& graph, unsigned int num_ev);
 
 	/** Applies MCL graph segmentation to a weighted, undirected graph */
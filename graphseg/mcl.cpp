@@ -0,0 +1,209 @@
+/*
+ * mcl.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "graphseg.hpp"
+#include "as_range.hpp"
+#include <Danvil/Tools/Parallel.h>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+namespace graphseg
+{
+
+namespace detail { namespace mcl
+{
+	/** Entries of a column with smaller values are removed after inflation */
+	constexpr float cPruneThreshold = 1e-4f;
+
+	/** Maximal number of entries kept per column after inflation */
+	constexpr unsigned int cMaxColumnEntries = 256;
+
+	/** Iteration stops if no entry changes by more than this */
+	constexpr float cConvergence = 1e-6f;
+
+	/** Number of columns processed by one task */
+	constexpr unsigned int cChunkSize = 32;
+
+	/** Non-zero entries (row and value) of a column sorted by row */
+	typedef std::vector<std::pair<unsigned int,float>> Column;
+
+	/** Sparse matrix stored by columns */
+	typedef std::vector<Column> Matrix;
+
+	/** Dense accumulator for one column with the list of rows which are in use */
+	struct Accumulator
+	{
+		std::vector<float> values;
+		std::vector<unsigned char> used;
+		std::vector<unsigned int> rows;
+
+		Accumulator(unsigned int dim)
+		:	values(dim, 0.0f), used(dim, 0) {}
+
+		void add(unsigned int i, float v) {
+			if(!used[i]) {
+				used[i] = 1;
+				rows.push_back(i);
+			}
+			values[i] += v;
+		}
+	};
+
+	/** Expansion and inflation of one column: (W*W).pow(p) followed by pruning and column normalization */
+	void ExpandInflateColumn(const Matrix& W, unsigned int j, float p, Accumulator& acc, Column& result)
+	{
+		// result column j is the linear combination of the columns k of W with coefficients w_kj
+		for(const auto& kw : W[j]) {
+			for(const auto& iw : W[kw.first]) {
+				acc.add(iw.first, iw.second * kw.second);
+			}
+		}
+		result.clear();
+		result.reserve(acc.rows.size());
+		for(unsigned int i : acc.rows) {
+			result.push_back(std::make_pair(i, std::pow(acc.values[i], p)));
+			acc.values[i] = 0.0f;
+			acc.used[i] = 0;
+		}
+		acc.rows.clear();
+		// normalization
+		float total = 0.0f;
+		for(const auto& iw : result) {
+			total += iw.second;
+		}
+		if(!(total > 0.0f)) {
+			result.clear();
+			return;
+		}
+		const float scl = 1.0f / total;
+		for(auto& iw : result) {
+			iw.second *= scl;
+		}
+		// pruning of small entries and of all but the largest entries
+		const std::size_t size_before = result.size();
+		result.erase(std::remove_if(result.begin(), result.end(),
+			[](const std::pair<unsigned int,float>& iw) { return iw.second < cPruneThreshold; }),
+			result.end());
+		if(result.size() > cMaxColumnEntries) {
+			std::nth_element(result.begin(), result.begin() + cMaxColumnEntries, result.end(),
+				[](const std::pair<unsigned int,float>& a, const std::pair<unsigned int,float>& b) { return a.second > b.second; });
+			result.resize(cMaxColumnEntries);
+		}
+		if(result.size() < size_before) {
+			float total_pruned = 0.0f;
+			for(const auto& iw : result) {
+				total_pruned += iw.second;
+			}
+			const float scl_pruned = 1.0f / total_pruned;
+			for(auto& iw : result) {
+				iw.second *= scl_pruned;
+			}
+		}
+		std::sort(result.begin(), result.end());
+	}
+
+	/** Largest absolute difference of the entries of two columns */
+	float ColumnChange(const Column& a, const Column& b)
+	{
+		float change = 0.0f;
+		auto ia = a.begin();
+		auto ib = b.begin();
+		while(ia != a.end() || ib != b.end()) {
+			if(ib == b.end() || (ia != a.end() && ia->first < ib->first)) {
+				change = std::max(change, std::abs(ia->second));
+				++ia;
+			}
+			else if(ia == a.end() || ib->first < ia->first) {
+				change = std::max(change, std::abs(ib->second));
+				++ib;
+			}
+			else {
+				change = std::max(change, std::abs(ia->second - ib->second));
+				++ia;
+				++ib;
+			}
+		}
+		return change;
+	}
+}}
+
+	SpectralGraph SolveMCL(const SpectralGraph& graph, float p, unsigned int iterations)
+	{
+		using namespace detail::mcl;
+		std::cout << "input graph has " << boost::num_edges(graph) << " edges" << std::endl;
+		const unsigned int dim = boost::num_vertices(graph);
+		// sparse adjacency matrix
+		Matrix W(dim);
+		for(auto eid : as_range(boost::edges(graph))) {
+			unsigned int ea = boost::source(eid, graph);
+			unsigned int eb = boost::target(eid, graph);
+			float ew = graph[eid];
+			W[eb].push_back(std::make_pair(ea, ew));
+			W[ea].push_back(std::make_pair(eb, ew));
+		}
+		for(Column& c : W) {
+			// duplicated edges overwrite each other
+			std::stable_sort(c.begin(), c.end(),
+				[](const std::pair<unsigned int,float>& a, const std::pair<unsigned int,float>& b) { return a.first < b.first; });
+			for(std::size_t i=1; i<c.size(); ) {
+				if(c[i].first == c[i-1].first) {
+					c[i-1].second = c[i].second;
+					c.erase(c.begin() + i);
+				}
+				else {
+					i++;
+				}
+			}
+			c.erase(std::remove_if(c.begin(), c.end(),
+				[](const std::pair<unsigned int,float>& iw) { return iw.second == 0.0f; }),
+				c.end());
+		}
+		// perform MCL
+		Matrix M(dim);
+		std::vector<float> column_change(dim);
+		// one accumulator per worker for all iterations (accumulators are cleared after each column)
+		std::vector<Accumulator> accumulators(Danvil::WorkerCount(dim, cChunkSize), Accumulator(dim));
+		for(unsigned int i=0; i<iterations; i++) {
+			Danvil::ParallelWorkerChunks(dim, cChunkSize,
+				[&W, &M, &column_change, &accumulators, p](unsigned int worker, std::size_t, std::size_t begin, std::size_t end) {
+					Accumulator& acc = accumulators[worker];
+					for(std::size_t j=begin; j<end; j++) {
+						ExpandInflateColumn(W, j, p, acc, M[j]);
+						column_change[j] = ColumnChange(W[j], M[j]);
+					}
+				});
+			std::swap(W, M);
+			std::size_t num_entries = 0;
+			for(const Column& c : W) {
+				num_entries += c.size();
+			}
+			const float change = column_change.empty() ? 0.0f : *std::max_element(column_change.begin(), column_change.end());
+			std::cout << "MCL " << i << " (entries=" << num_entries << ", change=" << change << ")" << std::endl;
+			if(change < cConvergence) {
+				break;
+			}
+		}
+		// create new graph with new edges
+		std::vector<std::pair<unsigned int,unsigned int>> edges;
+		std::vector<float> edge_weights;
+		for(unsigned int y=0; y<dim; y++) {
+			for(const auto& xw : W[y]) {
+				if(xw.second > 0.001f) {
+					edges.push_back(std::make_pair(xw.first, y));
+					edge_weights.push_back(xw.second);
+				}
+			}
+		}
+		SpectralGraph result(CreateCsrTopology(dim, edges),
+			std::vector<boost::no_property>(dim), std::move(edge_weights));
+		std::cout << "result graph has " << boost::num_edges(result) << " edges" << std::endl;
+		return result;
+	}
+
+}
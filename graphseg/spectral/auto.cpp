@@ -0,0 +1,297 @@
+/*
+ * auto.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "spectral.hpp"
+#include <Danvil/Tools/Benchmark.h>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace graphseg
+{
+
+namespace detail { namespace cost_model
+{
+	/** Version of the calibration file format (increase if cost functions change) */
+	constexpr unsigned int cVersion = 1;
+
+	/** Number of vertices of the calibration graph for dense solvers */
+	constexpr unsigned int cCalibrationDenseSize = 400;
+
+	/** Number of vertices of the calibration graph for sparse solvers */
+	constexpr unsigned int cCalibrationSparseSize = 2000;
+
+	/** Number of eigenvectors for calibration */
+	constexpr unsigned int cCalibrationNumEv = 24;
+
+	/** Number of measurements per solver (the fastest is used) */
+	constexpr unsigned int cCalibrationRepetitions = 2;
+
+	/** Exact solvers which can be selected */
+	const std::vector<SpectralMethod>& Candidates()
+	{
+		static const std::vector<SpectralMethod> candidates = {
+			SpectralMethod::Eigen
+			,SpectralMethod::Lapack
+			,SpectralMethod::Lanczos
+			,SpectralMethod::Lobpcg
+#ifdef USE_SOLVER_MAGMA
+			,SpectralMethod::Magma
+#endif
+#ifdef USE_SOLVER_ARPACK
+			,SpectralMethod::ArpackPP
+#endif
+#ifdef USE_SOLVER_IETL
+			,SpectralMethod::Ietl
+#endif
+		};
+		return candidates;
+	}
+
+	bool IsDense(SpectralMethod method)
+	{
+		return method == SpectralMethod::Eigen
+			|| method == SpectralMethod::Lapack
+#ifdef USE_SOLVER_MAGMA
+			|| method == SpectralMethod::Magma
+#endif
+			;
+	}
+
+	/** Cost of a solver up to a constant factor
+	 * Dense solvers are dominated by the tridiagonalization with O(N^3).
+	 * Sparse iterative solvers need O(k) sparse matrix vector products per
+	 * restart and orthogonalize O(k) vectors of length N.
+	 */
+	double Cost(SpectralMethod method, unsigned int num_vertices, unsigned int num_edges, unsigned int num_ev)
+	{
+		const double n = num_vertices;
+		const double e = num_edges;
+		const double k = num_ev + 1;
+		if(IsDense(method)) {
+			return n*n*n;
+		}
+		else {
+			return (n + e)*k + n*k*k;
+		}
+	}
+
+	/** Superpixel-like calibration graph: grid with three neighbours and random weights */
+	SpectralGraph CreateCalibrationGraph(unsigned int num_vertices)
+	{
+		const unsigned int w = std::max<unsigned int>(1, static_cast<unsigned int>(std::sqrt(static_cast<float>(num_vertices))));
+		std::mt19937 rnd(0);
+		std::uniform_real_distribution<float> uniform(0.05f, 1.0f);
+		std::vector<std::pair<unsigned int,unsigned int>> edges;
+		for(unsigned int i=0; i<num_vertices; i++) {
+			const unsigned int x = i % w;
+			if(x + 1 < w && i + 1 < num_vertices) {
+				edges.push_back(std::make_pair(i, i + 1));
+			}
+			if(i + w < num_vertices) {
+				edges.push_back(std::make_pair(i, i + w));
+			}
+			if(x + 1 < w && i + w + 1 < num_vertices) {
+				edges.push_back(std::make_pair(i, i + w + 1));
+			}
+		}
+		std::vector<float> weights(edges.size());
+		for(float& x : weights) {
+			x = uniform(rnd);
+		}
+		return SpectralGraph(CreateCsrTopology(num_vertices, edges),
+			std::vector<boost::no_property>(num_vertices), std::move(weights));
+	}
+
+	/** Measures the cost model constant (seconds per unit of cost) for each candidate solver */
+	std::map<std::string,double> Calibrate()
+	{
+		std::cout << "Calibrating spectral solver selection ..." << std::flush;
+		std::map<std::string,double> constants;
+		const SpectralGraph dense_graph = CreateCalibrationGraph(cCalibrationDenseSize);
+		const SpectralGraph sparse_graph = CreateCalibrationGraph(cCalibrationSparseSize);
+		for(SpectralMethod method : Candidates()) {
+			const SpectralGraph& graph = IsDense(method) ? dense_graph : sparse_graph;
+			double t_min = std::numeric_limits<double>::max();
+			for(unsigned int i=0; i<cCalibrationRepetitions; i++) {
+				const auto t0 = std::chrono::steady_clock::now();
+				solve(graph, boost::get(boost::edge_bundle, graph), cCalibrationNumEv, method);
+				const auto t1 = std::chrono::steady_clock::now();
+				t_min = std::min(t_min, std::chrono::duration<double>(t1 - t0).count());
+			}
+			constants[SpectralMethodName(method)] = t_min
+				/ Cost(method, boost::num_vertices(graph), boost::num_edges(graph), cCalibrationNumEv);
+		}
+		std::cout << " done" << std::endl;
+		return constants;
+	}
+
+	std::string CalibrationFilename()
+	{
+		const char* fn = std::getenv("GRAPHSEG_SPECTRAL_CALIBRATION");
+		if(fn) {
+			return fn;
+		}
+		const char* home = std::getenv("HOME");
+		if(home) {
+			return std::string(home) + "/.graphseg_spectral_calibration";
+		}
+		return ".graphseg_spectral_calibration";
+	}
+
+	/** Reads cost model constants from the calibration file
+	 * @return false if the file does not exist, has a different version or misses a solver
+	 */
+	bool LoadCalibration(const std::string& fn, std::map<std::string,double>& constants)
+	{
+		std::ifstream ifs(fn);
+		std::string tag;
+		unsigned int version;
+		if(!(ifs >> tag >> version) || tag != "graphseg_spectral_calibration" || version != cVersion) {
+			return false;
+		}
+		std::string name;
+		double c;
+		while(ifs >> name >> c) {
+			constants[name] = c;
+		}
+		for(SpectralMethod method : Candidates()) {
+			if(constants.find(SpectralMethodName(method)) == constants.end()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void SaveCalibration(const std::string& fn, const std::map<std::string,double>& constants)
+	{
+		std::ofstream ofs(fn);
+		if(!ofs.is_open()) {
+			std::cerr << "WARNING: Could not write spectral solver calibration file '" << fn << "'" << std::endl;
+			return;
+		}
+		ofs << "graphseg_spectral_calibration " << cVersion << std::endl;
+		ofs.precision(8);
+		for(const auto& p : constants) {
+			ofs << p.first << " " << std::scientific << p.second << std::endl;
+		}
+	}
+
+	/** Cost model constants measured on a single core (used if there is no calibration file) */
+	std::map<std::string,double> DefaultConstants()
+	{
+		std::map<std::string,double> constants = {
+			{"eigen", 2.0e-09},
+			{"lapack", 2.2e-10},
+			{"lanczos", 7.3e-08},
+			{"lobpcg", 5.7e-07}
+		};
+		// solvers without a measurement are only selected after calibration
+		for(SpectralMethod method : Candidates()) {
+			constants.insert(std::make_pair(SpectralMethodName(method), std::numeric_limits<double>::max()));
+		}
+		return constants;
+	}
+
+	std::mutex constants_mutex;
+
+	/** Cost model constants which are loaded on first use */
+	std::map<std::string,double>& Constants()
+	{
+		static std::map<std::string,double> constants;
+		static std::once_flag flag;
+		std::call_once(flag, []() {
+			if(!LoadCalibration(CalibrationFilename(), constants)) {
+				constants = DefaultConstants();
+			}
+		});
+		return constants;
+	}
+}}
+
+	SpectralMethod SelectSpectralMethod(unsigned int num_vertices, unsigned int num_edges, unsigned int num_ev)
+	{
+		using namespace detail::cost_model;
+		std::lock_guard<std::mutex> lock(constants_mutex);
+		const std::map<std::string,double>& constants = Constants();
+		SpectralMethod best = SpectralMethod::Eigen;
+		double best_time = std::numeric_limits<double>::max();
+		for(SpectralMethod method : Candidates()) {
+			const double t = constants.at(SpectralMethodName(method)) * Cost(method, num_vertices, num_edges, num_ev);
+			if(t < best_time) {
+				best = method;
+				best_time = t;
+			}
+		}
+#ifdef SPECTRAL_VERBOSE
+		std::cout << "DEBUG: Selected spectral solver " << SpectralMethodName(best) << " for N=" << num_vertices
+			<< ", E=" << num_edges << ", num_ev=" << num_ev << " (expected time " << best_time << " s)" << std::endl;
+#endif
+		return best;
+	}
+
+	void CalibrateSpectralMethodSelection()
+	{
+		using namespace detail::cost_model;
+		const std::map<std::string,double> measured = Calibrate();
+		SaveCalibration(CalibrationFilename(), measured);
+		std::lock_guard<std::mutex> lock(constants_mutex);
+		Constants() = measured;
+	}
+
+namespace detail
+{
+	std::vector<EigenComponent> SolveAuto(unsigned int num_vertices, unsigned int num_edges, unsigned int num_ev,
+		const std::function<std::vector<EigenComponent>(SpectralMethod)>& solve_fn, AutoSolveRecord* record)
+	{
+		const SpectralMethod selected = SelectSpectralMethod(num_vertices, num_edges, num_ev);
+		const auto t0 = std::chrono::steady_clock::now();
+		std::vector<EigenComponent> solution = solve_fn(selected);
+		const auto t1 = std::chrono::steady_clock::now();
+		const AutoSolveRecord r{selected, std::chrono::duration<double,std::milli>(t1 - t0).count()};
+		if(record) {
+			*record = r;
+		}
+		else {
+			ReportAutoSolve(r);
+		}
+		return solution;
+	}
+
+	void ReportAutoSolve(const AutoSolveRecord& record)
+	{
+		Danvil::Benchmark::Instance().add("spectral_auto_" + SpectralMethodName(record.method), record.time_ms);
+	}
+}
+
+	std::string SpectralMethodName(SpectralMethod method)
+	{
+		switch(method) {
+			case SpectralMethod::Eigen: return "eigen";
+#ifdef USE_SOLVER_ARPACK
+			case SpectralMethod::ArpackPP: return "arpackpp";
+#endif
+			case SpectralMethod::Lapack: return "lapack";
+			case SpectralMethod::Lanczos: return "lanczos";
+			case SpectralMethod::Lobpcg: return "lobpcg";
+			case SpectralMethod::Multilevel: return "multilevel";
+			case SpectralMethod::Auto: return "auto";
+#ifdef USE_SOLVER_MAGMA
+			case SpectralMethod::Magma: return "magma";
+#endif
+#ifdef USE_SOLVER_IETL
+			case SpectralMethod::Ietl: return "ietl";
+#endif
+			default: return "unknown";
+		}
+	}
+
+}
@@ -0,0 +1,118 @@
+/*
+ * components.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#ifndef GRAPHSEG_SPECTRAL_COMPONENTS_HPP_
+#define GRAPHSEG_SPECTRAL_COMPONENTS_HPP_
+
+#include "../Common.hpp"
+#include "../as_range.hpp"
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <iostream>
+
+namespace graphseg { namespace detail {
+
+/** Connected components of a graph */
+struct GraphComponents
+{
+	/** component of each vertex */
+	std::vector<unsigned int> vertex_component;
+
+	/** index of each vertex in its component */
+	std::vector<unsigned int> vertex_local;
+
+	/** vertices of each component */
+	std::vector<std::vector<unsigned int>> component_vertices;
+
+	/** edges (source and target local index and weight) of each component */
+	std::vector<std::vector<std::pair<std::pair<unsigned int,unsigned int>,float>>> component_edges;
+
+	unsigned int numComponents() const {
+		return component_vertices.size();
+	}
+};
+
+/** Finds connected components of a weighted graph
+ * Only edges with positive weight connect vertices. Edges with invalid
+ * weight (nan or negative) are reported and ignored.
+ */
+template<typename Graph, typename EdgeWeightMap>
+GraphComponents find_components(const Graph& graph, EdgeWeightMap edge_weights)
+{
+	constexpr unsigned int cNone = std::numeric_limits<unsigned int>::max();
+	const unsigned int n = boost::num_vertices(graph);
+	GraphComponents c;
+	c.vertex_component.resize(n, cNone);
+	c.vertex_local.resize(n);
+	// depth first search over edges with positive weight
+	std::vector<unsigned int> open;
+	for(unsigned int s=0; s<n; s++) {
+		if(c.vertex_component[s] != cNone) {
+			continue;
+		}
+		const unsigned int id = c.component_vertices.size();
+		c.component_vertices.push_back(std::vector<unsigned int>());
+		std::vector<unsigned int>& vertices = c.component_vertices.back();
+		c.vertex_component[s] = id;
+		open.push_back(s);
+		while(!open.empty()) {
+			const unsigned int u = open.back();
+			open.pop_back();
+			c.vertex_local[u] = vertices.size();
+			vertices.push_back(u);
+			for(auto eid : as_range(boost::out_edges(u, graph))) {
+				if(!(edge_weights[eid] > 0)) {
+					continue;
+				}
+				const unsigned int v = boost::target(eid, graph);
+				if(c.vertex_component[v] == cNone) {
+					c.vertex_component[v] = id;
+					open.push_back(v);
+				}
+			}
+		}
+	}
+	// distribute edges to components
+	c.component_edges.resize(c.component_vertices.size());
+	for(auto eid : as_range(boost::edges(graph))) {
+		const unsigned int ea = boost::source(eid, graph);
+		const unsigned int eb = boost::target(eid, graph);
+		const float ew = edge_weights[eid];
+		if(std::isnan(ew)) {
+			std::cerr << "ERROR: Weight for edge (" << ea << "," << eb << ") is nan!" << std::endl;
+			continue;
+		}
+		if(ew < 0) {
+			std::cerr << "ERROR: Weight for edge (" << ea << "," << eb << ") is negative!" << std::endl;
+			continue;
+		}
+		if(ew == 0 || ea == eb) {
+			continue;
+		}
+		c.component_edges[c.vertex_component[ea]].push_back(
+			std::make_pair(std::make_pair(c.vertex_local[ea], c.vertex_local[eb]), ew));
+	}
+	return c;
+}
+
+/** Closed form solution for a component with two vertices
+ * The generalized problem (D - W) x = \lambda D x with d_1 = d_2 = w has the
+ * trivial solution \lambda = 0, x = (1,1) and \lambda = 2, x = (1,-1) / sqrt(2 w).
+ */
+inline EigenComponent solve_two_vertices(float w)
+{
+	const float x = 1.0f / std::sqrt(2.0f * w);
+	EigenComponent ec;
+	ec.eigenvalue = 2.0f;
+	ec.eigenvector = Eigen::Vector2f(x, -x);
+	return ec;
+}
+
+}}
+
+#endif
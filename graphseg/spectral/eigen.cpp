@@ -6,7 +6,7 @@
 
 namespace graphseg { namespace detail {
 
-std::vector<EigenComponent> solver_eigen(const Eigen::MatrixXf& A, unsigned int num_ev)
+std::vector<EigenComponent> solver_eigen(const DenseMatrix& A, unsigned int num_ev)
 {
 	// solve eigensystem
 	Eigen::SelfAdjointEigenSolver<Eigen::MatrixXf> solver;
@@ -26,4 +26,14 @@ std::vector<EigenComponent> solver_eigen(const Eigen::MatrixXf& A, unsigned int
 	return solution;
 }
 
+std::vector<EigenComponent> solver_eigen_sparse(const SparseMatrix& A, unsigned int num_ev)
+{
+	// only the lower triangle is used
+	Eigen::MatrixXf M = Eigen::MatrixXf::Zero(A.dim, A.dim);
+	for(const SparseEntry& e : A.entries) {
+		M(e.i, e.j) = e.weight;
+	}
+	return solver_eigen(M, num_ev);
+}
+
 }}
@@ -0,0 +1,160 @@
+/*
+ * lanczos.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "solver.hpp"
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+namespace graphseg { namespace detail {
+
+namespace lanczos
+{
+	typedef Eigen::SparseMatrix<double> sparse_t;
+	typedef Eigen::MatrixXd matrix_t;
+	typedef Eigen::VectorXd vector_t;
+
+	/** Relative residual tolerance for Ritz pairs */
+	constexpr double cTolerance = 1e-6;
+
+	/** Maximal number of restarts */
+	constexpr unsigned int cMaxRestarts = 200;
+
+	/** Creates the full symmetric matrix B = 2 I - A from the lower triangle of A
+	 * The eigenvalues of the normalized Laplacian A are in [0,2]. The smallest
+	 * eigenvalues of A are the largest eigenvalues of B which are found faster.
+	 */
+	sparse_t CreateShiftedMatrix(const SparseMatrix& A)
+	{
+		std::vector<Eigen::Triplet<double>> triplets;
+		triplets.reserve(2*A.entries.size() + A.dim);
+		for(unsigned int i=0; i<A.dim; i++) {
+			triplets.push_back(Eigen::Triplet<double>(i, i, 2.0));
+		}
+		for(const SparseEntry& e : A.entries) {
+			triplets.push_back(Eigen::Triplet<double>(e.i, e.j, -e.weight));
+			if(e.i != e.j) {
+				triplets.push_back(Eigen::Triplet<double>(e.j, e.i, -e.weight));
+			}
+		}
+		sparse_t B(A.dim, A.dim);
+		B.setFromTriplets(triplets.begin(), triplets.end());
+		return B;
+	}
+
+	/** Orthogonalizes w against the first num columns of V (classical Gram-Schmidt applied twice)
+	 * @return projection coefficients V^T w
+	 */
+	vector_t Orthogonalize(const matrix_t& V, unsigned int num, vector_t& w)
+	{
+		vector_t h = V.leftCols(num).transpose() * w;
+		w -= V.leftCols(num) * h;
+		vector_t h2 = V.leftCols(num).transpose() * w;
+		w -= V.leftCols(num) * h2;
+		return h + h2;
+	}
+}
+
+std::vector<EigenComponent> solver_lanczos(const SparseMatrix& A, unsigned int num_ev)
+{
+	using namespace lanczos;
+	const unsigned int n = A.dim;
+	const unsigned int k = std::min(num_ev, n);
+	// size of the Krylov basis
+	const unsigned int m = std::max(2*k, k + 32);
+	if(n <= 2*m) {
+		// small problems are solved faster with a dense solver
+		return solver_eigen_sparse(A, num_ev);
+	}
+	// number of Ritz vectors kept on restart
+	const unsigned int num_keep = k + (m - k)/2;
+
+	const sparse_t B = CreateShiftedMatrix(A);
+
+	// Krylov basis with one additional column for the residual vector
+	matrix_t V(n, m + 1);
+	// projection T = V^T B V
+	matrix_t T = matrix_t::Zero(m, m);
+	// deterministic random start vector
+	std::mt19937 rnd(0);
+	std::uniform_real_distribution<double> uniform(-1.0, +1.0);
+	auto random_vector = [n, &rnd, &uniform]() {
+		vector_t v(n);
+		for(unsigned int i=0; i<n; i++) {
+			v[i] = uniform(rnd);
+		}
+		return v;
+	};
+	V.col(0) = random_vector().normalized();
+
+	Eigen::SelfAdjointEigenSolver<matrix_t> ritz;
+	unsigned int l = 0;
+	for(unsigned int restart=0; ; restart++) {
+		// extend basis from l to m vectors
+		double beta = 0.0;
+		for(unsigned int j=l; j<m; j++) {
+			vector_t w = B * V.col(j);
+			const vector_t h = Orthogonalize(V, j + 1, w);
+			T.col(j).head(j + 1) = h;
+			T.row(j).head(j + 1) = h.transpose();
+			beta = w.norm();
+			if(beta <= 1e-12 * std::max(1.0, h.norm())) {
+				// found an invariant subspace: continue with a new random direction
+				w = random_vector();
+				Orthogonalize(V, j + 1, w);
+				V.col(j + 1) = w.normalized();
+				beta = 0.0;
+			}
+			else {
+				V.col(j + 1) = w / beta;
+			}
+		}
+		// Ritz values and vectors (in ascending order)
+		ritz.compute(T);
+		const vector_t& theta = ritz.eigenvalues();
+		const matrix_t& Y = ritz.eigenvectors();
+		// residual norm of a Ritz pair is |beta * y_{m-1}|
+		unsigned int num_converged = 0;
+		for(unsigned int i=0; i<k; i++) {
+			const unsigned int q = m - 1 - i;
+			const double residual = std::abs(beta * Y(m - 1, q));
+			if(residual <= cTolerance * std::max(1.0, std::abs(theta[q]))) {
+				num_converged ++;
+			}
+		}
+#ifdef SPECTRAL_VERBOSE
+		std::cout << "DEBUG: Lanczos restart=" << restart << " converged=" << num_converged << "/" << k << std::endl;
+#endif
+		if(num_converged == k || restart + 1 == cMaxRestarts) {
+			if(num_converged < k) {
+				std::cerr << "WARNING: Lanczos solver did not converge (" << num_converged << " of " << k << " eigenpairs)" << std::endl;
+			}
+			// largest Ritz values of B are the smallest eigenvalues of A = 2 I - B
+			const matrix_t X = V.leftCols(m) * Y.rightCols(k);
+			std::vector<EigenComponent> solution(k);
+			for(unsigned int i=0; i<k; i++) {
+				const unsigned int q = k - 1 - i;
+				solution[i].eigenvalue = static_cast<float>(2.0 - theta[m - 1 - i]);
+				solution[i].eigenvector = X.col(q).cast<float>();
+			}
+			return solution;
+		}
+		// thick restart: keep the largest Ritz vectors and the residual vector
+		const matrix_t V_keep = V.leftCols(m) * Y.rightCols(num_keep);
+		V.leftCols(num_keep) = V_keep;
+		V.col(num_keep) = V.col(m);
+		T.setZero();
+		T.topLeftCorner(num_keep, num_keep).diagonal() = theta.tail(num_keep);
+		l = num_keep;
+	}
+}
+
+}}
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 
 extern "C" int ssyevr_(
 		char*,char*,char*,
@@ -21,112 +22,107 @@ extern "C" int ssyevr_(
 
 namespace graphseg { namespace detail {
 
-std::vector<EigenComponent> solver_lapack(const Eigen::MatrixXf& Ain, unsigned int num_ev)
+std::vector<EigenComponent> solver_lapack(const DenseMatrix& Ain, unsigned int num_ev)
 {
+	// ssyevr overwrites its input
 	Eigen::MatrixXf A = Ain;
 
-	// calling lapack!
-	std::cout << "LAPACK: Start!" << std::endl;
-
 	int N = A.rows();
-	std::cout << "N=" << N << std::endl;
+#ifdef SPECTRAL_VERBOSE
+	std::cout << "DEBUG: solver_lapack N=" << N << std::endl;
+#endif
 	float* data = A.data();
-	float vl, vu;
-	int il = 1, iu = num_ev;
+	int il = 1, iu = std::min<int>(num_ev, N);
 	float accuracy = 0.00001f;
 	int result_num_ew_found;
-	float* result_ew = new float[N];
-	float* result_ev = new float[N*N];
-	int* result_isuppz = new int[2*N];
+	// only the requested eigenvectors are stored
+	std::vector<float> result_ew(N);
+	std::vector<float> result_ev(N*iu);
+	std::vector<int> result_isuppz(2*iu);
 	int work_dim = -1;
-	float* work = new float[1];
+	float work_query;
 	int iwork_dim = -1;
-	int* iwork = new int[1];
+	int iwork_query;
 	int info;
 
-	// ssyevr_(
-	// 	"N", // JOBZ eigenvalues + eigenvectors
-	// 	"A", // RANGE only some eigenvalues
-	// 	"U", // UPLO upper triangle is stored
-	// 	&N, // N order of A
-	// 	data, // A upper triangle of A
-	// 	&N, // LDA leading dimension of A
-	// 	&vl, &vu, // VL,VU not used
-	// 	&il, &iu, // IL, IU  range of eigenvalues returned
-	// 	&accuracy, // ABSTOL accuracy
-	// 	&result_num_ew_found, // M number of eigenvalues found
-	// 	result_ew, // W computed eigenvalues
-	// 	result_ev, // Z computed eigenvectors
-	// 	&N, // LDZ leading dimension of Z
-	// 	result_isuppz, // ISUPPZ
-	// 	work, // WORK
-	// 	&work_dim, // LWORK
-	// 	iwork, // IWORK
-	// 	&iwork_dim, // LIWORK
-	// 	&info // INFO
-	// 	);
-	// work_dim = (int)*work;
-	// iwork_dim = *iwork;
-
-	work_dim = N*N;
-	iwork_dim = N*N;
+	// query optimal workspace sizes
+	ssyevr_(
+		"V", // JOBZ eigenvalues + eigenvectors
+		"I", // RANGE eigenvalues il to iu
+		"L", // UPLO lower triangle is stored
+		&N, // N order of A
+		data, // A lower triangle of A
+		&N, // LDA leading dimension of A
+		0, 0, // VL,VU not used
+		&il, &iu, // IL, IU  range of eigenvalues returned
+		&accuracy, // ABSTOL accuracy
+		&result_num_ew_found, // M number of eigenvalues found
+		result_ew.data(), // W computed eigenvalues
+		result_ev.data(), // Z computed eigenvectors
+		&N, // LDZ leading dimension of Z
+		result_isuppz.data(), // ISUPPZ
+		&work_query, // WORK
+		&work_dim, // LWORK
+		&iwork_query, // IWORK
+		&iwork_dim, // LIWORK
+		&info // INFO
+		);
+	work_dim = static_cast<int>(work_query);
+	iwork_dim = iwork_query;
 
-	delete[] work;
-	delete[] iwork;
-	std::cout << "LAPACK: work_dim (opt) =" << work_dim << std::endl;
-	std::cout << "LAPACK: iwork_dim (opt) =" << iwork_dim << std::endl;
-	work = new float[work_dim];
-	iwork = new int[iwork_dim];
+#ifdef SPECTRAL_VERBOSE
+	std::cout << "DEBUG: solver_lapack work_dim=" << work_dim << ", iwork_dim=" << iwork_dim << std::endl;
+#endif
+	std::vector<float> work(work_dim);
+	std::vector<int> iwork(iwork_dim);
 
 	ssyevr_(
 		"V", // JOBZ eigenvalues + eigenvectors
-		"A", // RANGE only some eigenvalues
-		"U", // UPLO upper triangle is stored
+		"I", // RANGE eigenvalues il to iu
+		"L", // UPLO lower triangle is stored
 		&N, // N order of A
-		data, // A upper triangle of A
+		data, // A lower triangle of A
 		&N, // LDA leading dimension of A
 		0, 0, // VL,VU not used
 		&il, &iu, // IL, IU  range of eigenvalues returned
 		&accuracy, // ABSTOL accuracy
 		&result_num_ew_found, // M number of eigenvalues found
-		result_ew, // W computed eigenvalues
-		result_ev, // Z computed eigenvectors
+		result_ew.data(), // W computed eigenvalues
+		result_ev.data(), // Z computed eigenvectors
 		&N, // LDZ leading dimension of Z
-		result_isuppz, // ISUPPZ
-		work, // WORK
+		result_isuppz.data(), // ISUPPZ
+		work.data(), // WORK
 		&work_dim, // LWORK
-		iwork, // IWORK
+		iwork.data(), // IWORK
 		&iwork_dim, // LIWORK
 		&info // INFO
 		);
 
-	std::cout << "LAPACK: Finished!" << std::endl;
-	std::cout << "Number of eigenvalues: " << result_num_ew_found << std::endl;
-	std::cout << "Info: " << info << std::endl;
+	if(info != 0) {
+		std::cerr << "ERROR: ssyevr failed with info=" << info << "!" << std::endl;
+		return {};
+	}
+#ifdef SPECTRAL_VERBOSE
+	std::cout << "DEBUG: solver_lapack found " << result_num_ew_found << " eigenvalues" << std::endl;
+#endif
 
 	// return eigenvectors and eigenvalues
 	std::vector<EigenComponent> solution(std::min<unsigned int>(num_ev, result_num_ew_found));
 	for(std::size_t i=0; i<solution.size(); i++) {
 		solution[i].eigenvalue = result_ew[i];
 #ifdef SPECTRAL_VERBOSE
-		std::cout << "SpectralSegmentation: eigenvalue #" << i << "=" << solution[i].eigenvalue << std::endl;
+		std::cout << "DEBUG:\teigenvalue #" << i << "=" << solution[i].eigenvalue << std::endl;
 #endif
 		solution[i].eigenvector = Eigen::VectorXf(N);
 		auto& ev = solution[i].eigenvector;
 		for(unsigned int j=0; j<N; j++) {
-			ev[j] = result_ev[i*N + j]; // FIXME correct order?
+			ev[j] = result_ev[i*N + j];
 		}
 #ifdef SPECTRAL_VERBOSE
 		std::cout << ev.transpose() << std::endl;
 #endif
 	}
 
-	delete[] result_ew;
-	delete[] result_ev;
-	delete[] result_isuppz;
-	delete[] work;
-	delete[] iwork;
-
 	return solution;
 }
 
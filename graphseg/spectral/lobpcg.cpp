@@ -0,0 +1,201 @@
+/*
+ * lobpcg.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "solver.hpp"
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+namespace graphseg { namespace detail {
+
+namespace lobpcg
+{
+	typedef Eigen::SparseMatrix<double> sparse_t;
+	typedef Eigen::MatrixXd matrix_t;
+	typedef Eigen::VectorXd vector_t;
+
+	/** Residual tolerance for eigenpairs */
+	constexpr double cTolerance = 1e-4;
+
+	/** Maximal number of iterations */
+	constexpr unsigned int cMaxIterations = 500;
+
+	/** Number of additional block vectors which speed up convergence of the last wanted eigenpairs */
+	constexpr unsigned int cNumGuardVectors = 8;
+
+	/** Creates the full symmetric matrix from the lower triangle of A */
+	sparse_t CreateMatrix(const SparseMatrix& A)
+	{
+		std::vector<Eigen::Triplet<double>> triplets;
+		triplets.reserve(2*A.entries.size());
+		for(const SparseEntry& e : A.entries) {
+			triplets.push_back(Eigen::Triplet<double>(e.i, e.j, e.weight));
+			if(e.i != e.j) {
+				triplets.push_back(Eigen::Triplet<double>(e.j, e.i, e.weight));
+			}
+		}
+		sparse_t M(A.dim, A.dim);
+		M.setFromTriplets(triplets.begin(), triplets.end());
+		return M;
+	}
+
+	/** Orthonormalizes the columns of Q against the orthonormal columns of X and each other
+	 * Columns are projected out of the span of X and orthonormalized with the
+	 * eigenvectors of their Gram matrix (SVQB) which only uses matrix-matrix
+	 * products. Both steps are applied twice. Linearly dependent columns are dropped.
+	 * @return number of remaining columns which are moved to the front of Q
+	 */
+	unsigned int Orthonormalize(const matrix_t& X, matrix_t& Q)
+	{
+		unsigned int num = Q.cols();
+		Eigen::SelfAdjointEigenSolver<matrix_t> solver;
+		for(unsigned int pass=0; pass<2 && num>0; pass++) {
+			auto Qn = Q.leftCols(num);
+			if(X.cols() > 0) {
+				const matrix_t H = X.transpose() * Qn;
+				Qn -= X * H;
+			}
+			// scale columns to unit length for a better conditioned Gram matrix
+			vector_t scl = Qn.colwise().norm().transpose();
+			for(unsigned int i=0; i<num; i++) {
+				scl[i] = (scl[i] > 0.0) ? 1.0 / scl[i] : 0.0;
+			}
+			const matrix_t G = scl.asDiagonal() * (Qn.transpose() * Qn) * scl.asDiagonal();
+			solver.compute(G);
+			const vector_t& lambda = solver.eigenvalues();
+			const double lambda_min = 1e-12 * std::max(lambda[num - 1], 1e-300);
+			// eigenvalues are in ascending order
+			unsigned int num_keep = 0;
+			while(num_keep < num && lambda[num - 1 - num_keep] > lambda_min) {
+				num_keep ++;
+			}
+			const matrix_t U = scl.asDiagonal() * solver.eigenvectors().rightCols(num_keep)
+				* lambda.tail(num_keep).cwiseSqrt().cwiseInverse().asDiagonal();
+			const matrix_t Q_new = Qn * U;
+			Q.leftCols(num_keep) = Q_new;
+			num = num_keep;
+		}
+		return num;
+	}
+}
+
+std::vector<EigenComponent> solver_lobpcg(const SparseMatrix& A, unsigned int num_ev, const Eigen::MatrixXf& initial, unsigned int* iterations)
+{
+	using namespace lobpcg;
+	if(iterations) {
+		*iterations = 0;
+	}
+	const unsigned int n = A.dim;
+	const unsigned int k = std::min(num_ev, n);
+	// block size
+	const unsigned int b = k + cNumGuardVectors;
+	if(n <= 4*b) {
+		// small problems are solved faster with a dense solver
+		return solver_eigen_sparse(A, num_ev);
+	}
+
+	const sparse_t M = CreateMatrix(A);
+
+	// initial block from the initial guess and deterministic random vectors
+	std::mt19937 rnd(0);
+	std::uniform_real_distribution<double> uniform(-1.0, +1.0);
+	matrix_t X(n, b);
+	unsigned int num_guess = 0;
+	if(initial.rows() == n) {
+		num_guess = std::min<unsigned int>(initial.cols(), b);
+		X.leftCols(num_guess) = initial.leftCols(num_guess).cast<double>();
+	}
+	else if(initial.size() > 0) {
+		std::cerr << "WARNING: LOBPCG initial guess has wrong dimension and is ignored" << std::endl;
+	}
+	for(unsigned int num=0; num<b; ) {
+		for(unsigned int c=num_guess; c<b; c++) {
+			for(unsigned int i=0; i<n; i++) {
+				X(i,c) = uniform(rnd);
+			}
+		}
+		num = Orthonormalize(matrix_t(n, 0), X);
+		// replace dropped columns with new random vectors
+		num_guess = num;
+	}
+
+	// Rayleigh-Ritz for the initial block
+	Eigen::SelfAdjointEigenSolver<matrix_t> ritz;
+	matrix_t AX = M * X;
+	{
+		const matrix_t T = X.transpose() * AX;
+		ritz.compute(0.5 * (T + T.transpose()));
+		X = X * ritz.eigenvectors();
+		AX = AX * ritz.eigenvectors();
+	}
+	vector_t theta = ritz.eigenvalues();
+
+	// search directions
+	matrix_t P(n, 0);
+	unsigned int iteration = 0;
+	for(; ; iteration++) {
+		// residuals
+		const matrix_t R = AX - X * theta.asDiagonal();
+		std::vector<unsigned int> active;
+		unsigned int num_converged = 0;
+		for(unsigned int i=0; i<k; i++) {
+			if(R.col(i).norm() > cTolerance) {
+				active.push_back(i);
+			}
+			else {
+				num_converged ++;
+			}
+		}
+#ifdef SPECTRAL_VERBOSE
+		std::cout << "DEBUG: LOBPCG iteration=" << iteration << " converged=" << num_converged << "/" << k << std::endl;
+#endif
+		if(num_converged == k || iteration == cMaxIterations) {
+			if(num_converged < k) {
+				std::cerr << "WARNING: LOBPCG solver did not converge (" << num_converged << " of " << k << " eigenpairs)" << std::endl;
+			}
+			break;
+		}
+		// residuals and search directions orthogonal to the current block
+		matrix_t Q(n, active.size() + P.cols());
+		for(unsigned int i=0; i<active.size(); i++) {
+			Q.col(i) = R.col(active[i]);
+		}
+		Q.rightCols(P.cols()) = P;
+		const unsigned int q = Orthonormalize(X, Q);
+		const auto Qq = Q.leftCols(q);
+		const matrix_t AQ = M * Qq;
+		// Rayleigh-Ritz in the subspace spanned by X and Q (note that X^T A X = diag(theta))
+		matrix_t T(b + q, b + q);
+		T.topLeftCorner(b, b) = theta.asDiagonal();
+		T.topRightCorner(b, q) = AX.transpose() * Qq;
+		T.bottomLeftCorner(q, b) = T.topRightCorner(b, q).transpose();
+		T.bottomRightCorner(q, q) = Qq.transpose() * AQ;
+		ritz.compute(0.5 * (T + T.transpose()));
+		const auto C = ritz.eigenvectors().leftCols(b);
+		theta = ritz.eigenvalues().head(b);
+		// new search directions are the components outside of the old block
+		P = Qq * C.bottomRows(q);
+		X = X * C.topRows(b) + P;
+		AX = AX * C.topRows(b) + AQ * C.bottomRows(q);
+	}
+	if(iterations) {
+		*iterations = iteration;
+	}
+
+	std::vector<EigenComponent> solution(k);
+	for(unsigned int i=0; i<k; i++) {
+		solution[i].eigenvalue = static_cast<float>(theta[i]);
+		solution[i].eigenvector = X.col(i).cast<float>();
+	}
+	return solution;
+}
+
+}}
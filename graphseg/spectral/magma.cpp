@@ -54,7 +54,7 @@ struct MagmaSpectralSolver
 	}
 };
 
-std::vector<EigenComponent> solver_magma(const Eigen::MatrixXf& A, unsigned int num_ev)
+std::vector<EigenComponent> solver_magma(const DenseMatrix& A, unsigned int num_ev)
 {
 	static MagmaSpectralSolver magma;
 
@@ -0,0 +1,195 @@
+/*
+ * multilevel.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: david
+ */
+
+#include "solver.hpp"
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+namespace graphseg { namespace detail {
+
+namespace multilevel
+{
+	typedef Eigen::SparseMatrix<double> sparse_t;
+	typedef Eigen::MatrixXd matrix_t;
+	typedef Eigen::VectorXd vector_t;
+
+	/** Coarsening stops at this number of vertices */
+	constexpr unsigned int cCoarseSize = 300;
+
+	/** Coarsening stops if a level does not reduce the number of vertices by at least this factor */
+	constexpr double cMinReduction = 0.85;
+
+	/** Number of refinement steps on each level */
+	constexpr unsigned int cRefinementSteps = 3;
+
+	/** Number of additional block vectors which improve the accuracy of the last wanted eigenpairs */
+	constexpr unsigned int cNumGuardVectors = 8;
+
+	/** One level of the hierarchy: matrix and prolongation to this level from the next coarser level */
+	struct Level
+	{
+		sparse_t A;
+		sparse_t Q;
+	};
+
+	/** Creates the full symmetric matrix from the lower triangle of A */
+	sparse_t CreateMatrix(const SparseMatrix& A)
+	{
+		std::vector<Eigen::Triplet<double>> triplets;
+		triplets.reserve(2*A.entries.size());
+		for(const SparseEntry& e : A.entries) {
+			triplets.push_back(Eigen::Triplet<double>(e.i, e.j, e.weight));
+			if(e.i != e.j) {
+				triplets.push_back(Eigen::Triplet<double>(e.j, e.i, e.weight));
+			}
+		}
+		sparse_t M(A.dim, A.dim);
+		M.setFromTriplets(triplets.begin(), triplets.end());
+		return M;
+	}
+
+	/** Heavy edge matching
+	 * Pairs each vertex with its unmatched neighbour of strongest affinity -a_ij.
+	 * The prolongation Q has orthonormal columns and maps the vertex weights t
+	 * of the coarse level to the vertex weights of the fine level (Q t_c = t).
+	 * With t = D^{1/2} 1 the coarse matrix Q^T A Q is again a normalized Laplacian.
+	 * @return prolongation matrix and coarse vertex weights t_c
+	 */
+	std::pair<sparse_t,vector_t> Coarsen(const sparse_t& A, const vector_t& t)
+	{
+		const unsigned int n = A.rows();
+		constexpr unsigned int cNone = static_cast<unsigned int>(-1);
+		std::vector<unsigned int> aggregate(n, cNone);
+		unsigned int num_aggregates = 0;
+		for(unsigned int u=0; u<n; u++) {
+			if(aggregate[u] != cNone) {
+				continue;
+			}
+			unsigned int best = cNone;
+			double best_affinity = 0.0;
+			for(sparse_t::InnerIterator it(A, u); it; ++it) {
+				const unsigned int v = it.row();
+				if(v != u && aggregate[v] == cNone && -it.value() > best_affinity) {
+					best = v;
+					best_affinity = -it.value();
+				}
+			}
+			aggregate[u] = num_aggregates;
+			if(best != cNone) {
+				aggregate[best] = num_aggregates;
+			}
+			num_aggregates ++;
+		}
+		// norm of vertex weights in each aggregate
+		vector_t tc = vector_t::Zero(num_aggregates);
+		std::vector<unsigned int> aggregate_size(num_aggregates, 0);
+		for(unsigned int i=0; i<n; i++) {
+			tc[aggregate[i]] += t[i]*t[i];
+			aggregate_size[aggregate[i]] ++;
+		}
+		tc = tc.cwiseSqrt();
+		std::vector<Eigen::Triplet<double>> triplets(n);
+		for(unsigned int i=0; i<n; i++) {
+			const unsigned int c = aggregate[i];
+			const double q = (tc[c] > 0.0) ? t[i] / tc[c] : 1.0 / std::sqrt(static_cast<double>(aggregate_size[c]));
+			triplets[i] = Eigen::Triplet<double>(i, c, q);
+		}
+		sparse_t Q(n, num_aggregates);
+		Q.setFromTriplets(triplets.begin(), triplets.end());
+		return std::make_pair(Q, tc);
+	}
+
+	/** Rayleigh-Ritz in the subspace spanned by X and the residuals A X - X theta
+	 * X is replaced by the Ritz vectors of the smallest Ritz values.
+	 */
+	void Refine(const sparse_t& A, matrix_t& X, vector_t& theta, unsigned int steps)
+	{
+		const unsigned int n = X.rows();
+		const unsigned int b = X.cols();
+		Eigen::SelfAdjointEigenSolver<matrix_t> ritz;
+		for(unsigned int s=0; s<steps && 2*b<=n; s++) {
+			matrix_t S(n, 2*b);
+			S.leftCols(b) = X;
+			S.rightCols(b) = A * X - X * theta.asDiagonal();
+			// orthonormal basis (Householder QR is stable for nearly dependent residuals)
+			Eigen::HouseholderQR<matrix_t> qr(S);
+			const matrix_t B = qr.householderQ() * matrix_t::Identity(n, 2*b);
+			const matrix_t T = B.transpose() * (A * B);
+			ritz.compute(0.5 * (T + T.transpose()));
+			X = B * ritz.eigenvectors().leftCols(b);
+			theta = ritz.eigenvalues().head(b);
+		}
+	}
+}
+
+std::vector<EigenComponent> solver_multilevel(const SparseMatrix& A, unsigned int num_ev, const Eigen::MatrixXf& initial)
+{
+	using namespace multilevel;
+	const unsigned int n = A.dim;
+	const unsigned int k = std::min(num_ev, n);
+	const unsigned int b = k + cNumGuardVectors;
+	const unsigned int coarse_size = std::max(cCoarseSize, 4*b);
+	if(n <= 2*coarse_size) {
+		// small problems are solved faster with a dense solver
+		return solver_eigen_sparse(A, num_ev);
+	}
+
+	// vertex weights for aggregation
+	vector_t t;
+	if(initial.rows() == n && initial.cols() > 0) {
+		t = initial.col(0).cast<double>().cwiseAbs();
+	}
+	else {
+		t = vector_t::Ones(n);
+	}
+
+	// coarsening
+	std::vector<Level> levels(1);
+	levels[0].A = CreateMatrix(A);
+	while(levels.back().A.rows() > coarse_size) {
+		const sparse_t& A_fine = levels.back().A;
+		const std::pair<sparse_t,vector_t> coarse = Coarsen(A_fine, t);
+		if(coarse.first.cols() > cMinReduction * A_fine.rows()) {
+			break;
+		}
+		Level level;
+		level.Q = coarse.first;
+		const sparse_t AQ = A_fine * level.Q;
+		level.A = level.Q.transpose() * AQ;
+		t = coarse.second;
+		levels.push_back(level);
+	}
+#ifdef SPECTRAL_VERBOSE
+	std::cout << "DEBUG: Multilevel levels=" << levels.size() << " coarse size=" << levels.back().A.rows() << std::endl;
+#endif
+
+	// dense solution on the coarsest level
+	const matrix_t A_coarse = matrix_t(levels.back().A);
+	Eigen::SelfAdjointEigenSolver<matrix_t> solver(0.5 * (A_coarse + A_coarse.transpose()));
+	const unsigned int b_coarse = std::min<unsigned int>(b, A_coarse.rows());
+	matrix_t X = solver.eigenvectors().leftCols(b_coarse);
+	vector_t theta = solver.eigenvalues().head(b_coarse);
+
+	// prolongation and refinement
+	for(int l=static_cast<int>(levels.size())-1; l>0; l--) {
+		X = levels[l].Q * X;
+		Refine(levels[l-1].A, X, theta, cRefinementSteps);
+	}
+
+	std::vector<EigenComponent> solution(std::min(k, b_coarse));
+	for(unsigned int i=0; i<solution.size(); i++) {
+		solution[i].eigenvalue = static_cast<float>(theta[i]);
+		solution[i].eigenvector = X.col(i).cast<float>();
+	}
+	return solution;
+}
+
+}}
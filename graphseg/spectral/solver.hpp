@@ -14,12 +14,32 @@
 namespace graphseg {
 namespace detail {
 
-	std::vector<EigenComponent> solver_eigen(const Eigen::MatrixXf& A, unsigned int num_ev);
+	std::vector<EigenComponent> solver_eigen(const DenseMatrix& A, unsigned int num_ev);
 
-	std::vector<EigenComponent> solver_lapack(const Eigen::MatrixXf& A, unsigned int num_ev);
+	/** Dense solver for a sparse matrix (used by iterative solvers for small problems) */
+	std::vector<EigenComponent> solver_eigen_sparse(const SparseMatrix& A, unsigned int num_ev);
+
+	std::vector<EigenComponent> solver_lapack(const DenseMatrix& A, unsigned int num_ev);
+
+	/** Thick-restart Lanczos solver for the smallest eigenvalues of a normalized graph Laplacian */
+	std::vector<EigenComponent> solver_lanczos(const SparseMatrix& A, unsigned int num_ev);
+
+	/** Block LOBPCG solver for the smallest eigenvalues of a normalized graph Laplacian
+	 * Columns of initial are used as start vectors (may be empty or have less than num_ev columns).
+	 * The number of iterations is written to iterations if not null.
+	 */
+	std::vector<EigenComponent> solver_lobpcg(const SparseMatrix& A, unsigned int num_ev, const Eigen::MatrixXf& initial, unsigned int* iterations);
+
+	/** Approximate multilevel solver for the smallest eigenvalues of a normalized graph Laplacian
+	 * The graph is coarsened by heavy edge matching, solved densely on the coarsest
+	 * level and the solution is refined with a few Rayleigh-Ritz steps on each finer level.
+	 * The first column of initial is used as vertex weights for coarsening and should
+	 * be the trivial solution D^{1/2} 1 (uniform weights if empty).
+	 */
+	std::vector<EigenComponent> solver_multilevel(const SparseMatrix& A, unsigned int num_ev, const Eigen::MatrixXf& initial);
 
 #ifdef USE_SOLVER_MAGMA
-	std::vector<EigenComponent> solver_magma(const Eigen::MatrixXf& A, unsigned int num_ev);
+	std::vector<EigenComponent> solver_magma(const DenseMatrix& A, unsigned int num_ev);
 #endif
 
 #ifdef USE_SOLVER_ARPACK
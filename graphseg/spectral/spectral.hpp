@@ -10,24 +10,62 @@
 
 #include "../graphseg.hpp"
 #include "spectral_impl.hpp"
+#include "components.hpp"
 #include "solver.hpp"
+#include <Danvil/Tools/Parallel.h>
+#include <algorithm>
+#include <numeric>
 
 namespace graphseg { namespace detail {
 
-	/** Computes n smallest eigenvalues/-vectors for a graph */
+	/** Solver selected by SpectralMethod::Auto and the time needed to solve */
+	struct AutoSolveRecord
+	{
+		SpectralMethod method;
+		double time_ms;
+	};
+
+	/** Selects a solver with SelectSpectralMethod and calls solve_fn with it
+	 * If record is not null the selected solver and the time are written to it
+	 * and must be reported with ReportAutoSolve, otherwise they are reported directly.
+	 */
+	std::vector<EigenComponent> SolveAuto(unsigned int num_vertices, unsigned int num_edges, unsigned int num_ev,
+		const std::function<std::vector<EigenComponent>(SpectralMethod)>& solve_fn, AutoSolveRecord* record);
+
+	/** Adds the time of an automatically selected solver to the benchmark under the tag spectral_auto_<solver>
+	 * Must not be called from worker threads.
+	 */
+	void ReportAutoSolve(const AutoSolveRecord& record);
+
+	/** Computes n smallest eigenvalues/-vectors for a graph
+	 * Dense solvers assemble the matrix in dense if it is not null (see solve_dense).
+	 */
 	template<typename Graph, typename EdgeWeightMap>
-	std::vector<EigenComponent> solve(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method)
+	std::vector<EigenComponent> solve(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method,
+		DenseEv* dense=nullptr)
 	{
 	using namespace std::placeholders;
 		// pick one eigenvalue more because the first one is omitted
 		switch(method) {
 			case SpectralMethod::Eigen:
-				return detail::solve_dense(graph, edge_weights, std::bind(&solver_eigen, _1, num_ev + 1));
+				return detail::solve_dense(graph, edge_weights, std::bind(&solver_eigen, _1, num_ev + 1), dense);
 			case SpectralMethod::Lapack:
-				return detail::solve_dense(graph, edge_weights, std::bind(&solver_lapack, _1, num_ev + 1));
+				return detail::solve_dense(graph, edge_weights, std::bind(&solver_lapack, _1, num_ev + 1), dense);
+			case SpectralMethod::Lanczos:
+				return detail::solve_sparse(graph, edge_weights, std::bind(&solver_lanczos, _1, num_ev + 1));
+			case SpectralMethod::Lobpcg:
+				return detail::solve_sparse(graph, edge_weights, std::bind(&solver_lobpcg, _1, num_ev + 1, Eigen::MatrixXf(), nullptr));
+			case SpectralMethod::Multilevel:
+				// the transformed constant vector D^{1/2} 1 is used as vertex weights
+				return detail::solve_sparse(graph, edge_weights, Eigen::MatrixXf::Ones(boost::num_vertices(graph), 1),
+					std::bind(&solver_multilevel, _1, num_ev + 1, _2));
+			case SpectralMethod::Auto: {
+				unsigned int iterations;
+				return solve(graph, edge_weights, num_ev, method, Eigen::MatrixXf(), iterations, nullptr, dense);
+			}
 #ifdef USE_SOLVER_MAGMA
 			case SpectralMethod::Magma:
-				return detail::solve_dense(graph, edge_weights, std::bind(&solver_magma, _1, num_ev + 1));
+				return detail::solve_dense(graph, edge_weights, std::bind(&solver_magma, _1, num_ev + 1), dense);
 #endif
 #ifdef USE_SOLVER_ARPACK
 			case SpectralMethod::ArpackPP:
@@ -43,22 +81,184 @@ namespace graphseg { namespace detail {
 		}
 	}
 
-	/** Applies graphseg graph theory fu to a weighted undirected graph */
+	/** Like solve, but starts iterative solvers with the columns of initial_guess
+	 * The number of solver iterations is written to iterations.
+	 * For SpectralMethod::Auto the selected solver is written to auto_record (see SolveAuto).
+	 */
 	template<typename Graph, typename EdgeWeightMap>
-	Graph graphseg_spectral(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method)
+	std::vector<EigenComponent> solve(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method,
+		const Eigen::MatrixXf& initial_guess, unsigned int& iterations, AutoSolveRecord* auto_record=nullptr, DenseEv* dense=nullptr)
+	{
+	using namespace std::placeholders;
+		iterations = 0;
+		switch(method) {
+			case SpectralMethod::Lobpcg:
+				return detail::solve_sparse(graph, edge_weights, initial_guess,
+					std::bind(&solver_lobpcg, _1, num_ev + 1, _2, &iterations));
+			case SpectralMethod::Auto:
+				return SolveAuto(boost::num_vertices(graph), boost::num_edges(graph), num_ev,
+					[&graph, &edge_weights, num_ev, &initial_guess, &iterations, dense](SpectralMethod selected) {
+						return solve(graph, edge_weights, num_ev, selected, initial_guess, iterations, nullptr, dense);
+					},
+					auto_record);
+			default:
+				return solve(graph, edge_weights, num_ev, method, dense);
+		}
+	}
+
+	/** Components up to this size are solved with the dense Eigen solver */
+	constexpr unsigned int cMaxDenseComponentSize = 64;
+
+	/** Computes the num_ev smallest non-trivial eigenvalues/-vectors of a graph
+	 * The graph is decomposed into connected components which are solved
+	 * independently and in parallel. Components with two vertices are solved in
+	 * closed form and small components with the dense Eigen solver. The trivial
+	 * solution (eigenvalue 0) of each component is omitted and eigenvectors are
+	 * zero outside of their component.
+	 * Iterative solvers are started with initial_guess (may be empty) and the
+	 * number of solver iterations summed over all components is written to iterations.
+	 */
+	template<typename Graph, typename EdgeWeightMap>
+	std::vector<EigenComponent> solve_components(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method,
+		const Eigen::MatrixXf& initial_guess, unsigned int& iterations)
+	{
+		const unsigned int n = boost::num_vertices(graph);
+		const GraphComponents components = find_components(graph, edge_weights);
+		const unsigned int num_components = components.numComponents();
+		const bool has_guess = (initial_guess.rows() == n && initial_guess.cols() > 0);
+		// solve largest components first for better load balancing
+		std::vector<unsigned int> order(num_components);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&components](unsigned int a, unsigned int b) {
+			return components.component_vertices[a].size() > components.component_vertices[b].size();
+		});
+		std::vector<std::vector<EigenComponent>> component_solution(num_components);
+		std::vector<unsigned int> component_iterations(num_components, 0);
+		// solvers selected by SpectralMethod::Auto are reported after the parallel loop
+		std::vector<AutoSolveRecord> component_auto(num_components, AutoSolveRecord{SpectralMethod::Auto, 0.0});
+		// one dense matrix per worker which is reused for all its components
+		std::vector<DenseEv> worker_dense(Danvil::WorkerCount(num_components, 1));
+		Danvil::ParallelWorkerChunks(num_components, 1, [&](unsigned int worker, std::size_t, std::size_t i, std::size_t) {
+			DenseEv& dense = worker_dense[worker];
+			const unsigned int id = order[i];
+			const std::vector<unsigned int>& vertices = components.component_vertices[id];
+			const auto& edges = components.component_edges[id];
+			const unsigned int size = vertices.size();
+			std::vector<EigenComponent>& solution = component_solution[id];
+			if(size == 1) {
+				// only the trivial solution
+				return;
+			}
+			if(size == 2) {
+				float w = 0.0f;
+				for(const auto& e : edges) {
+					w += e.second;
+				}
+				solution.push_back(solve_two_vertices(w));
+				return;
+			}
+			// graph of the component
+			std::vector<std::pair<unsigned int,unsigned int>> component_edges(edges.size());
+			std::vector<float> component_weights(edges.size());
+			for(unsigned int k=0; k<edges.size(); k++) {
+				component_edges[k] = edges[k].first;
+				component_weights[k] = edges[k].second;
+			}
+			const SpectralGraph component(CreateCsrTopology(size, component_edges),
+				std::vector<boost::no_property>(size), std::move(component_weights));
+			const unsigned int num = std::min(num_ev, size - 1);
+			std::vector<EigenComponent> result;
+			if(size <= cMaxDenseComponentSize) {
+				result = solve(component, boost::get(boost::edge_bundle, component), num, SpectralMethod::Eigen, &dense);
+			}
+			else {
+				// the constant vector is the trivial solution of each component
+				Eigen::MatrixXf component_guess;
+				if(has_guess) {
+					component_guess.resize(size, initial_guess.cols() + 1);
+					component_guess.col(0).setOnes();
+					for(unsigned int j=0; j<size; j++) {
+						component_guess.row(j).tail(initial_guess.cols()) = initial_guess.row(vertices[j]);
+					}
+				}
+				result = solve(component, boost::get(boost::edge_bundle, component), num, method,
+					component_guess, component_iterations[id], &component_auto[id], &dense);
+			}
+			// omit the trivial solution
+			if(!result.empty()) {
+				solution.assign(result.begin() + 1, result.end());
+			}
+		});
+		for(const AutoSolveRecord& r : component_auto) {
+			if(r.method != SpectralMethod::Auto) {
+				ReportAutoSolve(r);
+			}
+		}
+		// pick the smallest eigenvalues of all components
+		struct Candidate { float eigenvalue; unsigned int component; unsigned int index; };
+		std::vector<Candidate> candidates;
+		for(unsigned int id=0; id<num_components; id++) {
+			for(unsigned int i=0; i<component_solution[id].size(); i++) {
+				candidates.push_back(Candidate{component_solution[id][i].eigenvalue, id, i});
+			}
+		}
+		std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			return a.eigenvalue < b.eigenvalue;
+		});
+		candidates.resize(std::min<std::size_t>(candidates.size(), num_ev));
+		std::vector<EigenComponent> solution(candidates.size());
+		for(unsigned int i=0; i<candidates.size(); i++) {
+			const Candidate& c = candidates[i];
+			const EigenComponent& local = component_solution[c.component][c.index];
+			const std::vector<unsigned int>& vertices = components.component_vertices[c.component];
+			solution[i].eigenvalue = local.eigenvalue;
+			solution[i].eigenvector = Eigen::VectorXf::Zero(n);
+			for(unsigned int j=0; j<vertices.size(); j++) {
+				solution[i].eigenvector[vertices[j]] = local.eigenvector[j];
+			}
+		}
+		iterations = std::accumulate(component_iterations.begin(), component_iterations.end(), 0u);
+		return solution;
+	}
+
+	/** Creates a graph with the same topology and edge weights computed from the spectral solution */
+	template<typename Graph>
+	Graph graphseg_spectral_result(const Graph& graph, const std::vector<EigenComponent>& solution)
 	{
-		std::vector<EigenComponent> solution = solve(graph, edge_weights, num_ev, method);
 		Eigen::VectorXf weights = ev_to_graph_weights(graph, solution);
-		Graph result = graph;
-		// FIXME proper edge indexing
-		unsigned int eid_index = 0;
+		// the result shares the topology of the input graph
+		Graph result(graph.topology());
 		for(auto eid : as_range(boost::edges(result))) {
-			result[eid] = weights[eid_index];
-			eid_index++;
+			result[eid] = weights[boost::get(boost::get(boost::edge_index, result), eid)];
 		}
 		return result;
 	}
 
+	/** Applies graphseg graph theory fu to a weighted undirected graph */
+	template<typename Graph, typename EdgeWeightMap>
+	Graph graphseg_spectral(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method)
+	{
+		unsigned int iterations;
+		return graphseg_spectral_result(graph, solve_components(graph, edge_weights, num_ev, method, Eigen::MatrixXf(), iterations));
+	}
+
+	/** Like graphseg_spectral, but with an initial guess and the computed eigenvectors as output */
+	template<typename Graph, typename EdgeWeightMap>
+	Graph graphseg_spectral(const Graph& graph, EdgeWeightMap edge_weights, unsigned int num_ev, SpectralMethod method,
+		const SpectralSubspace& initial_guess, SpectralSubspace* subspace)
+	{
+		unsigned int iterations;
+		std::vector<EigenComponent> solution = solve_components(graph, edge_weights, num_ev, method, initial_guess.eigenvectors, iterations);
+		if(subspace) {
+			subspace->eigenvectors.resize(boost::num_vertices(graph), solution.size());
+			for(unsigned int i=0; i<solution.size(); i++) {
+				subspace->eigenvectors.col(i) = solution[i].eigenvector;
+			}
+			subspace->iterations = iterations;
+		}
+		return graphseg_spectral_result(graph, solution);
+	}
+
 }}
 
 #endif
@@ -11,6 +11,7 @@
 #include "../Common.hpp"
 #include "../as_range.hpp"
 #include <boost/graph/adjacency_list.hpp>
+#include <Danvil/Tools/Parallel.h>
 #include <functional>
 #include <iostream>
 #include <fstream>
@@ -24,28 +25,56 @@ namespace graphseg { namespace detail {
 
 constexpr float c_D_min = 0.001f;
 
-template<typename K>
-struct DenseGev
+/** Dense matrix of the transformed "normal" eigenvalue problem (see dense_graph_to_ev)
+ * The matrix storage only grows, so a DenseEv can be reused to solve several
+ * graphs without new allocations (see solve_components).
+ */
+struct DenseEv
 {
-	Eigen::Matrix<K,-1,-1> L;
-	Eigen::Matrix<K,-1,1> D;
+	/** Storage for the matrix A (column major) */
+	std::vector<float> storage;
+
+	/** Number of rows and columns of A */
+	unsigned int dim = 0;
+
+	Eigen::VectorXf D_inv_sqrt;
+
+	/** A := D^{-1/2} (D - W) D^{-1/2} (only the lower triangle is valid) */
+	Eigen::Map<Eigen::MatrixXf> A() {
+		return Eigen::Map<Eigen::MatrixXf>(storage.data(), dim, dim);
+	}
 };
 
-template<typename K, typename Graph, typename EdgeWeightMap>
-DenseGev<K> dense_graph_to_gev(const Graph& graph, EdgeWeightMap edge_weights)
+/** Assembles the matrix of the transformed eigenvalue problem directly from the graph
+ * The general eigenvalue problem
+ *     (D - W) x = \lambda D x
+ * can be transformed as follows:
+ * <=> D^{-1/2} (D - W) x = \lambda D^{1/2} x
+ * using z := D^{1/2} x i.e. x = D^{-1/2} z
+ * <=> D^{-1/2} (D - W) D^{-1/2} z = \lambda z
+ * Thus we have a "normal" eigenvalue problem A z = \lambda z with
+ *     A := D^{-1/2} (D - W) D^{-1/2}
+ * Using L := D - W this gives for coefficients:
+ *		a_ij = l_ij / \sqrt(d_i * d_j)
+ * where d_i := D_ii
+ * Neither W nor L are created: degrees are computed in a first pass over the
+ * edges and coefficients are written in a second pass. Only the lower triangle
+ * of A is written as dense solvers only reference the lower triangle.
+ */
+template<typename Graph, typename EdgeWeightMap>
+void dense_graph_to_ev(const Graph& graph, EdgeWeightMap edge_weights, DenseEv& ev)
 {
-	typedef Eigen::Matrix<K,-1,-1> matrix_t;
-	typedef Eigen::Matrix<K,-1,1> vector_t;
+	typedef float K;
 	const unsigned int dim = boost::num_vertices(graph);
-	// creating matrices
-	matrix_t W = matrix_t::Zero(dim,dim);
-	vector_t D = vector_t::Zero(dim);
 
 #ifdef SPECTRAL_VERBOSE
 	std::cout << "DEBUG: Number of vertices = " << boost::num_vertices(graph) << std::endl; 
 	std::cout << "DEBUG: Number of edges = " << boost::num_edges(graph) << std::endl; 
 #endif
 
+	// degrees
+	Eigen::VectorXf& D_inv_sqrt = ev.D_inv_sqrt;
+	D_inv_sqrt = Eigen::VectorXf::Zero(dim);
 	for(auto eid : as_range(boost::edges(graph))) {
 		unsigned int ea = boost::source(eid, graph);
 		unsigned int eb = boost::target(eid, graph);
@@ -58,30 +87,22 @@ DenseGev<K> dense_graph_to_gev(const Graph& graph, EdgeWeightMap edge_weights)
 			std::cerr << "ERROR: Weight for edge (" << ea << "," << eb << ") is negative!" << std::endl;
 			continue;
 		}
-		W(ea, eb) = ew;
-		W(eb, ea) = ew;
-		D[ea] += ew;
-		D[eb] += ew;
+		D_inv_sqrt[ea] += ew;
+		D_inv_sqrt[eb] += ew;
 	}
-	// connect disconnected segments to everything
-	// FIXME why is this necessary?
+	// Vertices without connections would give a singular D. Graphs are split
+	// into connected components before solving (see solve_components) so this
+	// only happens if a graph is solved directly.
 #ifdef SPECTRAL_VERBOSE
 	std::vector<int> nodes_with_no_connection;
 #endif
 	for(unsigned int i=0; i<dim; i++) {
-		K& di = D[i];
+		K& di = D_inv_sqrt[i];
 		if(di < c_D_min) {
 #ifdef SPECTRAL_VERBOSE
 			nodes_with_no_connection.push_back(i);
 #endif
-			// connect the disconnected cluster to all other clusters with a very small weight
 			di = static_cast<K>(1);
-			K q = di / static_cast<K>(dim-1);
-			for(unsigned int j=0; j<dim; j++) {
-				if(j == i) continue;
-				W(i,j) = q;
-				W(j,i) = q;
-			}
 		}
 	}
 #ifdef SPECTRAL_VERBOSE
@@ -93,49 +114,40 @@ DenseGev<K> dense_graph_to_gev(const Graph& graph, EdgeWeightMap edge_weights)
 		std::cout << std::endl;
 	}
 #endif	
-	// compute matrix L = D - W
-	matrix_t L = -W;
-	for(unsigned int i=0; i<dim; i++) {
-		L(i,i) += D[i];
+	// diagonal of L
+	Eigen::VectorXf L_diag = D_inv_sqrt;
+	D_inv_sqrt = D_inv_sqrt.array().sqrt().inverse().matrix();
+
+	// clear lower triangle
+	ev.dim = dim;
+	if(ev.storage.size() < static_cast<std::size_t>(dim)*dim) {
+		ev.storage.resize(static_cast<std::size_t>(dim)*dim);
+	}
+	Eigen::Map<Eigen::MatrixXf> A = ev.A();
+	for(unsigned int j=0; j<dim; j++) {
+		A.col(j).tail(dim - j).setZero();
 	}
-	// ready
-	return { L, D };
-}
-
-template<typename K>
-struct DenseGevTransformed
-{
-	Eigen::Matrix<K,-1,-1> A;
-	Eigen::Matrix<K,-1,1> D_inv_sqrt;
-};
 
-template<typename K>
-DenseGevTransformed<K> dense_gev_to_ev(const DenseGev<K>& gev)
-{
-	typedef Eigen::Matrix<K,-1,-1> matrix_t;
-	typedef Eigen::Matrix<K,-1,1> vector_t;
-	// The general eigenvalue problem
-	//     (D - W) x = \lambda D x
-	// can be transformed as follows:
-	// <=> D^{-1/2} (D - W) x = \lambda D^{1/2} x
-	// using z := D^{1/2} x i.e. x = D^{-1/2} z
-	// <=> D^{-1/2} (D - W) D^{-1/2} z = \lambda z
-	// Thus we have a "normal" eigenvalue problem A z = \lambda z with
-	//     A := D^{-1/2} (D - W) D^{-1/2}
-	// Using L := D - W this gives for coefficients:
-	//		a_ij = l_ij / \sqrt(d_i * d_j)
-	// where d_i := D_ii
-	const matrix_t& L = gev.L;
-	const vector_t& D = gev.D;
-	assert(L.cols() == L.rows());
-	assert(D.rows() == L.rows());
-	const unsigned int N = L.rows();
-	vector_t D_inv_sqrt = D.array().sqrt().inverse().matrix();
-	matrix_t A(N,N);
-	for(unsigned int i=0; i<N; i++) {
-		A.col(i) = D_inv_sqrt[i] * L.col(i).cwiseProduct(D_inv_sqrt);
+	// off-diagonal coefficients a_ij = -w_ij / \sqrt(d_i * d_j) with i > j
+	for(auto eid : as_range(boost::edges(graph))) {
+		unsigned int ea = boost::source(eid, graph);
+		unsigned int eb = boost::target(eid, graph);
+		K ew = edge_weights[eid];
+		if(std::isnan(ew) || ew < 0) {
+			continue;
+		}
+		if(ea == eb) {
+			L_diag[ea] -= ew;
+			continue;
+		}
+		if(ea < eb) {
+			std::swap(ea, eb);
+		}
+		A(ea, eb) = D_inv_sqrt[eb] * (-ew * D_inv_sqrt[ea]);
+	}
+	for(unsigned int i=0; i<dim; i++) {
+		A(i, i) = D_inv_sqrt[i] * (L_diag[i] * D_inv_sqrt[i]);
 	}
-	return { A, D_inv_sqrt };
 }
 
 template<typename K>
@@ -165,7 +177,6 @@ SparseGEVT<K> sparse_graph_entries(const Graph& graph, EdgeWeightMap edge_weight
 	// Thus the number of non-zero entries in the lower triangle is equal to
 	// the number of edges plus the number of nodes.
 	// This is not entirely true as some connections are possibly rejected.
-	// Additionally some connections may be added to assure global connectivity.
 	const int nnz_guess = boost::num_edges(graph) + n;
 
 	// collect all non-zero elements
@@ -177,7 +188,7 @@ SparseGEVT<K> sparse_graph_entries(const Graph& graph, EdgeWeightMap edge_weight
 
 	// also collect diagonal entries
 	Eigen::VectorXf& diag = sgevt.D_inv_sqrt;
-	diag = Eigen::VectorXf(n);
+	diag = Eigen::VectorXf::Zero(n);
 
 	// no collect entries
 	for(auto eid : as_range(boost::edges(graph))) {
@@ -203,32 +214,20 @@ SparseGEVT<K> sparse_graph_entries(const Graph& graph, EdgeWeightMap edge_weight
 		if(ea < eb) {
 			std::swap(ea, eb);
 		}
-		entries.push_back(SparseEntry{ea, eb, ew});
+		entries.push_back(SparseEntry{static_cast<unsigned int>(ea), static_cast<unsigned int>(eb), ew});
 		diag[ea] += ew;
 		diag[eb] += ew;
 	}
 
 	// do the conversion to a normal ev problem
-	// assure global connectivity
+	// Vertices without connections are decoupled (see dense_graph_to_ev).
 	for(unsigned int i=0; i<diag.size(); i++) {
 		K& v = diag[i];
 		if(v == 0) {
-			// connect the disconnected cluster to all other clusters with a very small weight
 			v = static_cast<K>(1);
-			K q = static_cast<K>(1) / static_cast<K>(n-1);
-			for(unsigned int j=0; j<i; j++) {
-				auto it = std::find_if(entries.begin(), entries.end(), [i, j](const SparseEntry& e) { return e.i == i && e.j == j; });
-				if(it == entries.end()) {
-					entries.push_back(SparseEntry{i, j, q});
-				}
-			}
-			for(unsigned int j=i+1; j<n; j++) {
-				auto it = std::find_if(entries.begin(), entries.end(), [j, i](const SparseEntry& e) { return e.i == j && e.j == i; });
-				if(it == entries.end()) {
-					entries.push_back(SparseEntry{j, i, q});
-				}
-			}
-			std::cerr << "ERROR: Diagonal is 0! (i=" << i << ")" << std::endl;
+#ifdef SPECTRAL_VERBOSE
+			std::cout << "DEBUG: Vertex " << i << " has no connections" << std::endl;
+#endif
 		}
 		else {
 			v = static_cast<K>(1) / std::sqrt(v);
@@ -261,7 +260,7 @@ SparseGEVT<K> sparse_graph_entries(const Graph& graph, EdgeWeightMap edge_weight
 template<typename K>
 void transform_gev_solution(const Eigen::Matrix<K,-1,1>& D_inv_sqrt, std::vector<EigenComponent>& ec)
 {
-	// We have x = D^{-1/2} z (see dense_gev_to_ev)
+	// We have x = D^{-1/2} z (see dense_graph_to_ev)
 	// thus x_i = z_i / \sqrt(d_i)
 	const unsigned int dim = D_inv_sqrt.rows();
 	for(std::size_t i=0; i<ec.size(); i++) {
@@ -273,7 +272,6 @@ void transform_gev_solution(const Eigen::Matrix<K,-1,1>& D_inv_sqrt, std::vector
 template<typename Graph>
 Eigen::VectorXf ev_to_graph_weights(const Graph& graph, const std::vector<EigenComponent>& solution)
 {
-	typedef Eigen::Matrix<float,-1,-1> matrix_t;
 	typedef Eigen::Matrix<float,-1,1> vector_t;
 	vector_t edge_weight = vector_t::Zero(boost::num_edges(graph));
 //	// later we weight by eigenvalues
@@ -298,49 +296,72 @@ Eigen::VectorXf ev_to_graph_weights(const Graph& graph, const std::vector<EigenC
 //		weights[k] = 1.0f / std::sqrt(ew);
 //	}
 //	std::cout << "Weights = " << weights.transpose() << std::endl;
+	// endpoints of all edges (in edge index order)
+	const unsigned int num_edges = boost::num_edges(graph);
+	std::vector<unsigned int> edge_a, edge_b;
+	edge_a.reserve(num_edges);
+	edge_b.reserve(num_edges);
+	for(auto eid : as_range(boost::edges(graph))) {
+		edge_a.push_back(boost::source(eid, graph));
+		edge_b.push_back(boost::target(eid, graph));
+	}
 	// look into first eigenvectors
-	// skip first component
+	std::vector<unsigned int> used;
 	for(unsigned int k=0; k<solution.size(); k++) {
-		const EigenComponent& eigen = solution[k];
 		// omit if eigenvalue is not positive
-		float ew = eigen.eigenvalue;
 		// FIXME this is due to numerical instabilities
-		if(ew <= 0.0001f) {
-			continue;
+		if(solution[k].eigenvalue > 0.0001f) {
+			used.push_back(k);
 		}
+	}
+	const unsigned int num_used = used.size();
+	if(num_used == 0) {
+		return edge_weight;
+	}
+	const unsigned int dim = solution[used.front()].eigenvector.rows();
+	typedef Eigen::Matrix<float,-1,-1,Eigen::RowMajor> row_matrix_t;
+	constexpr unsigned int cBlockSize = 1024;
+	// normalized eigenvectors are stored row-wise so that the values of
+	// all eigenvectors for one vertex are contiguous
+	row_matrix_t V(dim, num_used);
+	vector_t w(num_used);
+	vector_t ev_min(num_used);
+	vector_t ev_range(num_used);
+	for(unsigned int j=0; j<num_used; j++) {
+		const EigenComponent& eigen = solution[used[j]];
 		// weight by eigenvalue
-		float w = 1.0f / std::sqrt(ew);
-		// get eigenvector and normalize
-		vector_t ev = eigen.eigenvector;
-		ev = (ev - ev.minCoeff() * vector_t::Ones(ev.rows())) / (ev.maxCoeff() - ev.minCoeff());
-		// for each edge compute difference of eigenvector values
-		vector_t e_k = vector_t::Zero(edge_weight.rows());
-		// FIXME proper edge indexing
-		unsigned int eid_index = 0;
-		for(auto eid : as_range(boost::edges(graph))) {
-			e_k[eid_index] = std::abs(ev[boost::source(eid, graph)] - ev[boost::target(eid, graph)]);
-			eid_index++;
-		}
+		w[j] = 1.0f / std::sqrt(eigen.eigenvalue);
+		ev_min[j] = eigen.eigenvector.minCoeff();
+		ev_range[j] = eigen.eigenvector.maxCoeff() - ev_min[j];
 #ifdef SPECTRAL_VERBOSE
-		std::cout << "DEBUG w=" << w << " e_k.maxCoeff()=" << e_k.maxCoeff() << std::endl;
+		std::cout << "DEBUG w=" << w[j] << std::endl;
 #endif
-//		e_k /= e_k.maxCoeff();
-//		for(unsigned int i=0; i<e_k.rows(); i++) {
-//			e_k[i] = std::exp(-e_k[i]);
-//		}
-		e_k *= w;
-
-#ifdef SEGS_DBG_PRINT
-		{
-			std::ofstream ofs((boost::format("/tmp/edge_weights_%03d.txt") % k).str());
-			for(unsigned int i=0; i<e_k.rows(); i++) {
-				ofs << e_k[i] << std::endl;
+	}
+	// get eigenvectors and normalize to [0,1]
+	Danvil::ParallelChunks(dim, cBlockSize,
+		[&solution, &used, &V, &ev_min, &ev_range, num_used](std::size_t, std::size_t begin, std::size_t end) {
+			for(std::size_t i=begin; i<end; i++) {
+				for(unsigned int j=0; j<num_used; j++) {
+					V(i,j) = (solution[used[j]].eigenvector[i] - ev_min[j]) / ev_range[j];
+				}
 			}
+		});
+	// for each edge the weighted sum of eigenvector value differences
+	// (vectorized over eigenvectors and parallel over blocks of edges)
+	Danvil::ParallelChunks(num_edges, cBlockSize,
+		[&edge_a, &edge_b, &V, &w, &edge_weight](std::size_t, std::size_t begin, std::size_t end) {
+			for(std::size_t i=begin; i<end; i++) {
+				edge_weight[i] = (V.row(edge_a[i]) - V.row(edge_b[i])).cwiseAbs().dot(w.transpose());
+			}
+		});
+#ifdef SEGS_DBG_PRINT
+	for(unsigned int j=0; j<num_used; j++) {
+		std::ofstream ofs((boost::format("/tmp/edge_weights_%03d.txt") % used[j]).str());
+		for(unsigned int i=0; i<num_edges; i++) {
+			ofs << w[j] * std::abs(V(edge_a[i],j) - V(edge_b[i],j)) << std::endl;
 		}
-#endif
-		//
-		edge_weight += e_k;
 	}
+#endif
 	return edge_weight;
 }
 
@@ -360,27 +381,25 @@ inline void print_matrix(std::ostream& os, const Eigen::Matrix<K,ROWS,COLS>& m)
 	}
 }
 
+/** Solves the graph with a dense solver
+ * The matrix is assembled in dense if not null and in a temporary DenseEv otherwise.
+ */
 template<typename Graph, typename EdgeWeightMap>
 std::vector<EigenComponent> solve_dense(const Graph& graph, EdgeWeightMap edge_weights,
-	const std::function<std::vector<EigenComponent>(const Eigen::MatrixXf&)>& solver)
+	const std::function<std::vector<EigenComponent>(const DenseMatrix&)>& solver, DenseEv* dense=nullptr)
 {
-	typedef float K;
+	DenseEv temporary;
+	DenseEv& ev = dense ? *dense : temporary;
 
-	DenseGev<K> gev = dense_graph_to_gev<K>(graph, edge_weights);
+	dense_graph_to_ev(graph, edge_weights, ev);
 #ifdef SEGS_DBG_PRINT
-		{	std::ofstream ofs("/tmp/L.tsv"); print_matrix(ofs, gev.L); }
-		{	std::ofstream ofs("/tmp/D.tsv"); print_matrix(ofs, gev.D); }
+		{	std::ofstream ofs("/tmp/A.tsv"); print_matrix(ofs, Eigen::MatrixXf(ev.A().selfadjointView<Eigen::Lower>())); }
+		{	std::ofstream ofs("/tmp/D_inv_sqrt.tsv"); print_matrix(ofs, ev.D_inv_sqrt); }
 #endif
 
-	DenseGevTransformed<K> gevt = dense_gev_to_ev(gev);
-#ifdef SEGS_DBG_PRINT
-		{	std::ofstream ofs("/tmp/A.tsv"); print_matrix(ofs, gevt.A); }
-		{	std::ofstream ofs("/tmp/D_inv_sqrt.tsv"); print_matrix(ofs, gevt.D_inv_sqrt); }
-#endif
-
-	std::vector<EigenComponent> v_ec = solver(gevt.A);
+	std::vector<EigenComponent> v_ec = solver(ev.A());
 
-	transform_gev_solution(gevt.D_inv_sqrt, v_ec);
+	transform_gev_solution(ev.D_inv_sqrt, v_ec);
 
 	return v_ec;
 }
@@ -396,6 +415,25 @@ std::vector<EigenComponent> solve_sparse(const Graph& graph, EdgeWeightMap edge_
 	return v_ec;
 }
 
+/** Like solve_sparse, but passes an initial guess to the solver
+ * The initial guess X (one eigenvector per column) is given for the general
+ * problem and is transformed to Z = D^{1/2} X (see transform_gev_solution).
+ */
+template<typename Graph, typename EdgeWeightMap>
+std::vector<EigenComponent> solve_sparse(const Graph& graph, EdgeWeightMap edge_weights, const Eigen::MatrixXf& initial,
+	const std::function<std::vector<EigenComponent>(const SparseMatrix&, const Eigen::MatrixXf&)>& solver)
+{
+	typedef float K;
+	SparseGEVT<K> sgevt = sparse_graph_entries<K>(graph, edge_weights);
+	Eigen::MatrixXf initial_z;
+	if(initial.rows() == sgevt.D_inv_sqrt.rows()) {
+		initial_z = sgevt.D_inv_sqrt.cwiseInverse().asDiagonal() * initial;
+	}
+	std::vector<EigenComponent> v_ec = solver(sgevt.A, initial_z);
+	transform_gev_solution(sgevt.D_inv_sqrt, v_ec);
+	return v_ec;
+}
+
 }}
 
 #endif
@@ -0,0 +1,569 @@
+#include <graphseg/Common.hpp>
+#include <graphseg/graphseg.hpp>
+#include <graphseg/Labeling.hpp>
+#include <graphseg/as_range.hpp>
+#include <graphseg/spectral/spectral.hpp>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/copy.hpp>
+#include <boost/program_options.hpp>
+#include <boost/timer/timer.hpp>
+#include <sys/resource.h>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <set>
+#include <cmath>
+
+/** Edges of a superpixel-like test graph
+ * Vertices are placed on a grid and are connected to their right, lower
+ * and lower right neighbours which gives an average degree of about 6.
+ */
+std::vector<std::pair<unsigned int,unsigned int>> TestGraphEdges(unsigned int num_vertices)
+{
+	const unsigned int w = std::max<unsigned int>(1, static_cast<unsigned int>(std::sqrt(static_cast<float>(num_vertices))));
+	std::vector<std::pair<unsigned int,unsigned int>> edges;
+	for(unsigned int i=0; i<num_vertices; i++) {
+		const unsigned int x = i % w;
+		const bool has_right = (x + 1 < w && i + 1 < num_vertices);
+		const bool has_down = (i + w < num_vertices);
+		if(has_right) {
+			edges.push_back(std::make_pair(i, i + 1));
+		}
+		if(has_down) {
+			edges.push_back(std::make_pair(i, i + w));
+		}
+		if(has_right && i + w + 1 < num_vertices) {
+			edges.push_back(std::make_pair(i, i + w + 1));
+		}
+	}
+	return edges;
+}
+
+/** Superpixel-like weighted test graph
+ * Vertices are grouped into square regions with similar values. Edge weights
+ * are similarities exp(-|v_a - v_b|) with some noise.
+ * A fraction of vertices is isolated (all edge weights zero) like invalid
+ * superpixels in noisy frames.
+ */
+graphseg::SpectralGraph TestWeightedGraph(unsigned int num_vertices, float isolated=0.0f, unsigned int seed=0)
+{
+	const std::vector<std::pair<unsigned int,unsigned int>> edges = TestGraphEdges(num_vertices);
+	const unsigned int w = std::max<unsigned int>(1, static_cast<unsigned int>(std::sqrt(static_cast<float>(num_vertices))));
+	std::mt19937 rnd(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	std::vector<float> region_value(w*w);
+	for(float& v : region_value) {
+		v = 4.0f * uniform(rnd);
+	}
+	std::vector<float> value(num_vertices);
+	for(unsigned int i=0; i<num_vertices; i++) {
+		const unsigned int rx = (i % w) * 8 / w;
+		const unsigned int ry = (i / w) * 8 / w;
+		value[i] = region_value[rx + 8*ry] + 0.2f * uniform(rnd);
+	}
+	std::vector<float> weights(edges.size());
+	for(unsigned int k=0; k<edges.size(); k++) {
+		weights[k] = std::exp(-std::abs(value[edges[k].first] - value[edges[k].second]));
+	}
+	std::vector<bool> is_isolated(num_vertices);
+	for(unsigned int i=0; i<num_vertices; i++) {
+		is_isolated[i] = (uniform(rnd) < isolated);
+	}
+	for(unsigned int k=0; k<edges.size(); k++) {
+		if(is_isolated[edges[k].first] || is_isolated[edges[k].second]) {
+			weights[k] = 0.0f;
+		}
+	}
+	return graphseg::SpectralGraph(graphseg::CreateCsrTopology(num_vertices, edges),
+		std::vector<boost::no_property>(num_vertices), std::move(weights));
+}
+
+/** Average time in microseconds of f over a number of repetitions */
+double MeasureMicroseconds(unsigned int repetitions, const std::function<void()>& f)
+{
+	boost::timer::cpu_timer timer;
+	for(unsigned int k=0; k<repetitions; k++) {
+		f();
+	}
+	return static_cast<double>(timer.elapsed().wall) / 1000.0 / static_cast<double>(repetitions);
+}
+
+/** Compares boost::adjacency_list and graphseg::CsrGraph
+ * Construction: graph from an edge list
+ * Traversal: sum of edge weights over all edges and over all out edges of all vertices
+ * Reweight: new weighted graph with the same structure (copy_graph vs shared topology)
+ */
+void BenchmarkGraph(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int repetitions)
+{
+	typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS, boost::no_property, float> AdjacencyGraph;
+	std::cout << "nodes\tedges\tadj_build\tcsr_build\tadj_traverse\tcsr_traverse\tadj_reweight\tcsr_reweight\t[us]" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const std::vector<std::pair<unsigned int,unsigned int>> edges = TestGraphEdges(n);
+		// construction
+		AdjacencyGraph adj;
+		const double t_adj_build = MeasureMicroseconds(repetitions, [&]() {
+			adj = AdjacencyGraph(n);
+			for(const auto& e : edges) {
+				auto p = boost::add_edge(e.first, e.second, adj);
+				adj[p.first] = 1.0f;
+			}
+		});
+		graphseg::SpectralGraph csr;
+		const double t_csr_build = MeasureMicroseconds(repetitions, [&]() {
+			csr = graphseg::SpectralGraph(graphseg::CreateCsrTopology(n, edges),
+				std::vector<boost::no_property>(n), std::vector<float>(edges.size(), 1.0f));
+		});
+		// traversal
+		float sum_adj = 0.0f;
+		const double t_adj_traverse = MeasureMicroseconds(repetitions, [&]() {
+			for(auto eid : as_range(boost::edges(adj))) {
+				sum_adj += adj[eid];
+			}
+			for(auto vid : as_range(boost::vertices(adj))) {
+				for(auto eid : as_range(boost::out_edges(vid, adj))) {
+					sum_adj += adj[eid] * static_cast<float>(boost::target(eid, adj));
+				}
+			}
+		});
+		float sum_csr = 0.0f;
+		const double t_csr_traverse = MeasureMicroseconds(repetitions, [&]() {
+			for(auto eid : as_range(boost::edges(csr))) {
+				sum_csr += csr[eid];
+			}
+			for(auto vid : as_range(boost::vertices(csr))) {
+				for(auto eid : as_range(boost::out_edges(vid, csr))) {
+					sum_csr += csr[eid] * static_cast<float>(boost::target(eid, csr));
+				}
+			}
+		});
+		if(sum_adj != sum_csr) {
+			std::cerr << "ERROR: Traversal results differ (" << sum_adj << " vs " << sum_csr << ")!" << std::endl;
+		}
+		// new edge weights for the same graph
+		const double t_adj_reweight = MeasureMicroseconds(repetitions, [&]() {
+			AdjacencyGraph result;
+			boost::copy_graph(adj, result,
+				boost::edge_copy([&adj,&result](AdjacencyGraph::edge_descriptor src, AdjacencyGraph::edge_descriptor dst) {
+					result[dst] = 2.0f * adj[src];
+				}));
+		});
+		const double t_csr_reweight = MeasureMicroseconds(repetitions, [&]() {
+			graphseg::SpectralGraph result(csr.topology());
+			for(auto eid : as_range(boost::edges(csr))) {
+				result[eid] = 2.0f * csr[eid];
+			}
+		});
+		std::cout << n << "\t" << edges.size() << std::fixed << std::setprecision(1)
+			<< "\t" << t_adj_build << "\t" << t_csr_build
+			<< "\t" << t_adj_traverse << "\t" << t_csr_traverse
+			<< "\t" << t_adj_reweight << "\t" << t_csr_reweight << std::endl;
+	}
+}
+
+/** Fraction of edges for which both labelings agree if the edge is inside a segment or not */
+float SegmentAgreement(const graphseg::SpectralGraph& graph, const graphseg::GraphLabeling& a, const graphseg::GraphLabeling& b)
+{
+	unsigned int num_agree = 0;
+	for(auto eid : as_range(boost::edges(graph))) {
+		const unsigned int ea = boost::source(eid, graph);
+		const unsigned int eb = boost::target(eid, graph);
+		if((a.labels[ea] == a.labels[eb]) == (b.labels[ea] == b.labels[eb])) {
+			num_agree ++;
+		}
+	}
+	return static_cast<float>(num_agree) / static_cast<float>(std::max<unsigned int>(1, boost::num_edges(graph)));
+}
+
+/** Compares spectral solvers
+ * For each graph size the eigenvalues, the edge weights computed by
+ * SolveSpectral and the resulting segmentation (see SegmentAgreement) are
+ * compared to the result of the dense Eigen solver (or the first solver
+ * which was run). Dense solvers are only run up to dense_max nodes.
+ */
+void BenchmarkSpectral(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int num_ev, unsigned int dense_max, float isolated, float threshold)
+{
+	struct Method {
+		std::string name;
+		graphseg::SpectralMethod method;
+		bool is_dense;
+	};
+	const std::vector<Method> methods = {
+		{"eigen", graphseg::SpectralMethod::Eigen, true},
+		{"lapack", graphseg::SpectralMethod::Lapack, true},
+		{"lanczos", graphseg::SpectralMethod::Lanczos, false},
+		{"lobpcg", graphseg::SpectralMethod::Lobpcg, false},
+		{"multilevel", graphseg::SpectralMethod::Multilevel, false},
+		{"auto", graphseg::SpectralMethod::Auto, false}
+	};
+	std::cout << "nodes\tmethod\ttime[ms]\tmax_ev_error\tmax_weight_error\tsegment_agreement" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const graphseg::SpectralGraph graph = TestWeightedGraph(n, isolated);
+		std::vector<graphseg::detail::EigenComponent> reference;
+		Eigen::VectorXf reference_weights;
+		graphseg::GraphLabeling reference_labels;
+		for(const Method& m : methods) {
+			if(m.is_dense && n > dense_max) {
+				continue;
+			}
+			std::vector<graphseg::detail::EigenComponent> solution;
+			Eigen::VectorXf weights;
+			unsigned int iterations;
+			boost::timer::cpu_timer timer;
+			solution = graphseg::detail::solve_components(graph, boost::get(boost::edge_bundle, graph), num_ev, m.method, Eigen::MatrixXf(), iterations);
+			weights = graphseg::detail::ev_to_graph_weights(graph, solution);
+			const double t = static_cast<double>(timer.elapsed().wall) / 1000000.0;
+			const graphseg::GraphLabeling labels = graphseg::ComputeSegmentLabels(
+				graphseg::detail::graphseg_spectral_result(graph, solution), threshold);
+			std::cout << n << "\t" << m.name << "\t" << std::fixed << std::setprecision(1) << t;
+			if(reference.empty()) {
+				reference = solution;
+				reference_weights = weights;
+				reference_labels = labels;
+				std::cout << "\t-\t-\t-" << std::endl;
+			}
+			else {
+				float ev_error = 0.0f;
+				for(unsigned int i=0; i<std::min(solution.size(), reference.size()); i++) {
+					ev_error = std::max(ev_error, std::abs(solution[i].eigenvalue - reference[i].eigenvalue));
+				}
+				const float weight_error = (weights - reference_weights).cwiseAbs().maxCoeff() / reference_weights.cwiseAbs().maxCoeff();
+				const float agreement = SegmentAgreement(graph, labels, reference_labels);
+				std::cout << std::scientific << std::setprecision(2) << "\t" << ev_error << "\t" << weight_error
+					<< std::fixed << std::setprecision(4) << "\t" << agreement << std::endl;
+			}
+		}
+	}
+}
+
+/** Reference implementation of MCL with dense matrices (the original SolveMCL) */
+Eigen::MatrixXf SolveMCLDense(const graphseg::SpectralGraph& graph, float p, unsigned int iterations)
+{
+	const unsigned int dim = boost::num_vertices(graph);
+	Eigen::MatrixXf W = Eigen::MatrixXf::Zero(dim, dim);
+	for(auto eid : as_range(boost::edges(graph))) {
+		W(boost::source(eid, graph), boost::target(eid, graph)) = graph[eid];
+		W(boost::target(eid, graph), boost::source(eid, graph)) = graph[eid];
+	}
+	for(unsigned int i=0; i<iterations; i++) {
+		Eigen::MatrixXf M = (W*W).array().pow(p).matrix();
+		for(unsigned int j=0; j<dim; j++) {
+			const float total = M.col(j).sum();
+			if(total > 0.0f) {
+				M.col(j) *= 1.0f / total;
+			}
+		}
+		W = M;
+	}
+	return W;
+}
+
+/** Clusters of an MCL result are the connected components of the result graph */
+graphseg::GraphLabeling MCLClusters(const graphseg::SpectralGraph& result)
+{
+	const graphseg::detail::GraphComponents c = graphseg::detail::find_components(result, boost::get(boost::edge_bundle, result));
+	graphseg::GraphLabeling labeling;
+	labeling.labels.assign(c.vertex_component.begin(), c.vertex_component.end());
+	labeling.num_labels = c.numComponents();
+	return labeling;
+}
+
+/** Compares sparse SolveMCL with the dense reference implementation
+ * The dense reference is only run up to dense_max nodes.
+ */
+void BenchmarkMCL(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int dense_max, float p, unsigned int iterations)
+{
+	std::cout << "nodes\tsparse[ms]\tdense[ms]\tclusters\tmax_weight_error\tcluster_agreement" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const graphseg::SpectralGraph graph = TestWeightedGraph(n);
+		boost::timer::cpu_timer timer;
+		const graphseg::SpectralGraph result = graphseg::SolveMCL(graph, p, iterations);
+		const double t_sparse = static_cast<double>(timer.elapsed().wall) / 1000000.0;
+		const graphseg::GraphLabeling clusters = MCLClusters(result);
+		std::cout << n << "\t" << std::fixed << std::setprecision(1) << t_sparse;
+		if(n > dense_max) {
+			std::cout << "\t-\t" << clusters.num_labels << "\t-\t-" << std::endl;
+			continue;
+		}
+		timer.start();
+		Eigen::MatrixXf W = SolveMCLDense(graph, p, iterations);
+		const double t_dense = static_cast<double>(timer.elapsed().wall) / 1000000.0;
+		// result graph of the reference
+		std::vector<std::pair<unsigned int,unsigned int>> edges;
+		std::vector<float> edge_weights;
+		for(unsigned int y=0; y<n; y++) {
+			for(unsigned int x=0; x<n; x++) {
+				if(W(x,y) > 0.001f) {
+					edges.push_back(std::make_pair(x, y));
+					edge_weights.push_back(W(x,y));
+				}
+			}
+		}
+		const graphseg::SpectralGraph reference(graphseg::CreateCsrTopology(n, edges),
+			std::vector<boost::no_property>(n), std::move(edge_weights));
+		Eigen::MatrixXf W_sparse = Eigen::MatrixXf::Zero(n, n);
+		for(auto eid : as_range(boost::edges(result))) {
+			W_sparse(boost::source(eid, result), boost::target(eid, result)) = result[eid];
+		}
+		for(unsigned int y=0; y<n; y++) {
+			for(unsigned int x=0; x<n; x++) {
+				if(!(W(x,y) > 0.001f)) {
+					W(x,y) = 0.0f;
+				}
+			}
+		}
+		const float weight_error = (W_sparse - W).cwiseAbs().maxCoeff();
+		const float agreement = SegmentAgreement(graph, clusters, MCLClusters(reference));
+		std::cout << "\t" << t_dense << "\t" << clusters.num_labels
+			<< std::scientific << std::setprecision(2) << "\t" << weight_error
+			<< std::fixed << std::setprecision(4) << "\t" << agreement << std::endl;
+	}
+}
+
+/** Reference implementation of UCM which merges labels with std::replace (the original ComputeSegmentLabels_UCM) */
+graphseg::GraphLabeling ComputeSegmentLabelsUCMReference(const graphseg::SpectralGraph& graph, float threshold)
+{
+	std::vector<int> labels(boost::num_vertices(graph));
+	for(unsigned int i=0; i<labels.size(); i++) {
+		labels[i] = i;
+	}
+	struct Edge { unsigned int a, b; float weight; };
+	std::vector<Edge> edges;
+	for(auto eid : as_range(boost::edges(graph))) {
+		edges.push_back(Edge{boost::source(eid, graph), boost::target(eid, graph), graph[eid]});
+	}
+	std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y){ return x.weight < y.weight; });
+	for(const Edge& e : edges) {
+		if(e.weight >= threshold) {
+			break;
+		}
+		const int l_old = labels[e.a];
+		const int l_new = labels[e.b];
+		std::replace(labels.begin(), labels.end(), l_old, l_new);
+	}
+	return graphseg::GraphLabeling::CreateClean(labels);
+}
+
+/** Compares UCM segmentation with the reference implementation
+ * Reports the time for one threshold and for a sweep over num_thresholds
+ * thresholds with the merge hierarchy (build once, extract for each threshold).
+ */
+void BenchmarkUCM(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int repetitions, unsigned int num_thresholds)
+{
+	std::cout << "nodes\treference[us]\tucm[us]\thierarchy_build[us]\thierarchy_extract[us]\tsweep_reference[ms]\tsweep_hierarchy[ms]\tidentical" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const graphseg::SpectralGraph graph = TestWeightedGraph(n);
+		std::vector<float> thresholds(num_thresholds);
+		for(unsigned int i=0; i<num_thresholds; i++) {
+			thresholds[i] = static_cast<float>(i + 1) / static_cast<float>(num_thresholds);
+		}
+		const float threshold = 0.5f;
+		graphseg::GraphLabeling a, b;
+		const double t_reference = MeasureMicroseconds(repetitions, [&]() {
+			a = ComputeSegmentLabelsUCMReference(graph, threshold);
+		});
+		const double t_ucm = MeasureMicroseconds(repetitions, [&]() {
+			b = graphseg::ComputeSegmentLabels_UCM(graph, threshold);
+		});
+		graphseg::UcmHierarchy hierarchy;
+		const double t_build = MeasureMicroseconds(repetitions, [&]() {
+			hierarchy = graphseg::ComputeUcmHierarchy(graph);
+		});
+		const double t_extract = MeasureMicroseconds(repetitions, [&]() {
+			b = hierarchy.labeling(threshold);
+		});
+		// threshold sweep
+		bool identical = (a.labels == b.labels && a.num_labels == b.num_labels);
+		std::vector<graphseg::GraphLabeling> sweep_a(num_thresholds), sweep_b(num_thresholds);
+		const double t_sweep_reference = MeasureMicroseconds(1, [&]() {
+			for(unsigned int i=0; i<num_thresholds; i++) {
+				sweep_a[i] = ComputeSegmentLabelsUCMReference(graph, thresholds[i]);
+			}
+		}) / 1000.0;
+		const double t_sweep_hierarchy = MeasureMicroseconds(1, [&]() {
+			const graphseg::UcmHierarchy h = graphseg::ComputeUcmHierarchy(graph);
+			for(unsigned int i=0; i<num_thresholds; i++) {
+				sweep_b[i] = h.labeling(thresholds[i]);
+			}
+		}) / 1000.0;
+		for(unsigned int i=0; i<num_thresholds; i++) {
+			identical = identical && sweep_a[i].labels == sweep_b[i].labels
+				&& sweep_a[i].num_labels == sweep_b[i].num_labels
+				&& hierarchy.numSegments(thresholds[i]) == sweep_b[i].num_labels;
+		}
+		std::cout << n << std::fixed << std::setprecision(1)
+			<< "\t" << t_reference << "\t" << t_ucm << "\t" << t_build << "\t" << t_extract
+			<< "\t" << t_sweep_reference << "\t" << t_sweep_hierarchy
+			<< "\t" << (identical ? "yes" : "NO") << std::endl;
+	}
+}
+
+/** Reference implementation of GraphLabeling::relabel with std::set and std::find */
+void RelabelReference(graphseg::GraphLabeling& labeling)
+{
+	std::set<int> unique_labels_set(labeling.labels.begin(), labeling.labels.end());
+	std::vector<int> unique_labels(unique_labels_set.begin(), unique_labels_set.end());
+	labeling.num_labels = unique_labels.size();
+	for(int& x : labeling.labels) {
+		x = std::find(unique_labels.begin(), unique_labels.end(), x) - unique_labels.begin();
+	}
+}
+
+/** Compares GraphLabeling::relabel with the reference implementation
+ * Labels are UCM segment labels for a vertex (dense label range) and the
+ * same labels scaled by a large factor (sparse label range).
+ */
+void BenchmarkRelabel(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int repetitions)
+{
+	std::cout << "nodes\tlabels\treference[us]\tdense[us]\tsparse[us]\tidentical" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const graphseg::SpectralGraph graph = TestWeightedGraph(n);
+		const graphseg::UcmHierarchy hierarchy = graphseg::ComputeUcmHierarchy(graph);
+		// raw segment labels
+		graphseg::GraphLabeling raw;
+		raw.labels.resize(n);
+		for(unsigned int i=0; i<n; i++) {
+			int node = i;
+			while(hierarchy.parent[node] >= 0 && hierarchy.merge_weight[hierarchy.parent[node] - n] < 0.5f) {
+				node = hierarchy.parent[node];
+			}
+			raw.labels[i] = hierarchy.node_label[node];
+		}
+		graphseg::GraphLabeling sparse_raw = raw;
+		for(int& x : sparse_raw.labels) {
+			x *= 100003;
+		}
+		graphseg::GraphLabeling a, b, c;
+		const double t_reference = MeasureMicroseconds(repetitions, [&]() {
+			a = raw;
+			RelabelReference(a);
+		});
+		const double t_dense = MeasureMicroseconds(repetitions, [&]() {
+			b = raw;
+			b.relabel();
+		});
+		const double t_sparse = MeasureMicroseconds(repetitions, [&]() {
+			c = sparse_raw;
+			c.relabel();
+		});
+		const bool identical = (a.labels == b.labels && a.labels == c.labels
+			&& a.num_labels == b.num_labels && a.num_labels == c.num_labels);
+		std::cout << n << "\t" << a.num_labels << std::fixed << std::setprecision(1)
+			<< "\t" << t_reference << "\t" << t_dense << "\t" << t_sparse
+			<< "\t" << (identical ? "yes" : "NO") << std::endl;
+	}
+}
+
+/** Peak resident memory of the process in MB */
+double PeakMemoryMB()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	// ru_maxrss is given in kilobytes
+	return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+/** Assembly of the dense matrix for dense spectral solvers
+ * Reports assembly time, size of the matrix buffer and increase of the peak
+ * resident memory of the process.
+ */
+void BenchmarkAssembly(unsigned int num_min, unsigned int num_max, unsigned int num_steps, unsigned int repetitions)
+{
+	std::cout << "nodes\tedges\ttime[ms]\tbuffer[MB]\tpeak_increase[MB]" << std::endl;
+	for(unsigned int step=0; step<num_steps; step++) {
+		const unsigned int n = (num_steps == 1) ? num_min : num_min + (num_max - num_min)*step/(num_steps - 1);
+		const graphseg::SpectralGraph graph = TestWeightedGraph(n);
+		const double peak_before = PeakMemoryMB();
+		graphseg::detail::DenseEv ev;
+		const double t = MeasureMicroseconds(repetitions, [&]() {
+			graphseg::detail::dense_graph_to_ev(graph, boost::get(boost::edge_bundle, graph), ev);
+		}) / 1000.0;
+		const double buffer = static_cast<double>(ev.storage.size() * sizeof(float)) / 1024.0 / 1024.0;
+		std::cout << n << "\t" << boost::num_edges(graph) << std::fixed << std::setprecision(2)
+			<< "\t" << t << "\t" << buffer << "\t" << PeakMemoryMB() - peak_before << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string p_mode = "graph";
+	unsigned int p_min = 500;
+	unsigned int p_max = 5000;
+	unsigned int p_steps = 4;
+	unsigned int p_repetitions = 20;
+	unsigned int p_num_ev = 24;
+	unsigned int p_dense_max = 10000;
+	float p_isolated = 0.0f;
+	float p_threshold = 1.0f;
+	float p_mcl_p = 2.0f;
+	unsigned int p_mcl_iterations = 20;
+	unsigned int p_num_thresholds = 50;
+
+	namespace po = boost::program_options;
+	po::options_description desc;
+	desc.add_options()
+		("help", "produce help message")
+		("mode", po::value(&p_mode), "benchmark to run: graph, spectral, assembly, mcl, ucm, relabel, or calibrate to measure the solver selection of SpectralMethod::Auto")
+		("min", po::value(&p_min), "smallest number of graph nodes")
+		("max", po::value(&p_max), "largest number of graph nodes (default 5000 for graph and 10000 for spectral)")
+		("steps", po::value(&p_steps), "number of graph sizes")
+		("repetitions", po::value(&p_repetitions), "number of repetitions per measurement")
+		("num_ev", po::value(&p_num_ev), "number of eigenvectors for spectral solving")
+		("dense_max", po::value(&p_dense_max), "largest number of graph nodes for dense spectral solvers")
+		("isolated", po::value(&p_isolated), "fraction of isolated graph nodes for spectral solving")
+		("threshold", po::value(&p_threshold), "segmentation threshold for spectral solving")
+		("mcl_p", po::value(&p_mcl_p), "inflation exponent for MCL")
+		("mcl_iterations", po::value(&p_mcl_iterations), "number of MCL iterations")
+		("num_thresholds", po::value(&p_num_thresholds), "number of thresholds for segmentation sweeps")
+	;
+
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+	if(vm.count("help")) {
+		std::cerr << desc << std::endl;
+		return 1;
+	}
+
+	if(p_mode == "graph") {
+		BenchmarkGraph(p_min, p_max, p_steps, p_repetitions);
+	}
+	else if(p_mode == "spectral") {
+		if(vm.count("max") == 0) {
+			p_max = 10000;
+		}
+		BenchmarkSpectral(p_min, p_max, p_steps, p_num_ev, p_dense_max, p_isolated, p_threshold);
+	}
+	else if(p_mode == "mcl") {
+		if(vm.count("dense_max") == 0) {
+			p_dense_max = 2000;
+		}
+		BenchmarkMCL(p_min, p_max, p_steps, p_dense_max, p_mcl_p, p_mcl_iterations);
+	}
+	else if(p_mode == "ucm") {
+		BenchmarkUCM(p_min, p_max, p_steps, p_repetitions, p_num_thresholds);
+	}
+	else if(p_mode == "relabel") {
+		BenchmarkRelabel(p_min, p_max, p_steps, p_repetitions);
+	}
+	else if(p_mode == "assembly") {
+		BenchmarkAssembly(p_min, p_max, p_steps, p_repetitions);
+	}
+	else if(p_mode == "calibrate") {
+		graphseg::CalibrateSpectralMethodSelection();
+	}
+	else {
+		std::cerr << "Unknown mode '" << p_mode << "'!" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -11,32 +11,46 @@
 #include "Point.hpp"
 #include "graphseg/as_range.hpp"
 #include "graphseg/graphseg.hpp"
-#include <boost/graph/adjacency_list.hpp>
+#include "graphseg/CsrGraph.hpp"
+#include <boost/range/iterator_range.hpp>
 #include <Eigen/Dense>
+#include <vector>
 
 namespace dasp
 {
 	struct NeighbourhoodProperties
 	{
 		unsigned int num_border_pixels;
-		std::vector<unsigned int> border_pixel_ids;
+		// offset of the first border pixel in NeighbourhoodGraphProperties::border_pixels
+		unsigned int border_pixel_offset;
+	};
+
+	struct NeighbourhoodGraphProperties
+	{
+		// border pixels of all edges in index form x + y*w stored contiguously in edge order
+		std::vector<unsigned int> border_pixels;
 	};
 
 	/** Undirected graph */
-	typedef boost::adjacency_list<
-		boost::vecS, boost::vecS, boost::undirectedS,
+	typedef graphseg::CsrGraph<
 		boost::no_property,
-		NeighbourhoodProperties
+		NeighbourhoodProperties,
+		NeighbourhoodGraphProperties
 	> NeighbourhoodGraph;
 
+	/** Border pixels of an edge of the neighbourhood graph in index form x + y*w */
+	inline boost::iterator_range<const unsigned int*> BorderPixelIds(const NeighbourhoodGraph& graph, const NeighbourhoodGraph::edge_descriptor& eid)
+	{
+		const NeighbourhoodProperties& p = graph[eid];
+		const unsigned int* begin = graph[boost::graph_bundle].border_pixels.data() + p.border_pixel_offset;
+		return boost::make_iterator_range(begin, begin + p.num_border_pixels);
+	}
+
 	/** Undirected, weighted (type=float) graph */
 	typedef graphseg::SpectralGraph UndirectedWeightedGraph;
 
 	/** Weighted graph of superpoints */
-	typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS,
-		Point,
-		float
-	> DaspGraph;
+	typedef graphseg::CsrGraph<Point, float> DaspGraph;
 
 }
 
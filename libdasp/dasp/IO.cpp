@@ -148,7 +148,9 @@ namespace dasp
 		constexpr unsigned int num_values_per_edge_min = 2;
 		constexpr unsigned int num_values_per_edge_max = 3;
 
-		DaspGraph g;
+		std::vector<Point> points;
+		std::vector<std::pair<unsigned int,unsigned int>> edges;
+		std::vector<float> weights;
 
 		// load superpixel vertices
 		{
@@ -174,8 +176,8 @@ namespace dasp
 				std::transform(tokens.begin(), tokens.end(), values.begin(),
 					[](const std::string& str) { return boost::lexical_cast<float>(str); });
 				// add vertex to graph
-				auto vid = boost::add_vertex(g);
-				Point& p = g[vid];
+				points.push_back(Point());
+				Point& p = points.back();
 				p.px = values[0];
 				p.py = values[1];
 				p.position	= Eigen::Vector3f(values[2], values[3], values[4]);
@@ -207,13 +209,18 @@ namespace dasp
 				unsigned int e_target = boost::lexical_cast<unsigned int>(tokens[1]);
 				float weight = (tokens.size() == 3) ? boost::lexical_cast<float>(tokens[2]) : 0.0f;
 				// add edge to graph
-				auto result = boost::add_edge(e_source, e_target, g);
-				// set edge weight
-				g[result.first] = weight;
+				edges.push_back(std::make_pair(e_source, e_target));
+				weights.push_back(weight);
 			}
 		}		
 
-		return g;
+		const unsigned int num_vertices = points.size();
+		for(const auto& e : edges) {
+			if(e.first >= num_vertices || e.second >= num_vertices) {
+				throw std::runtime_error("Invalid dasp edge vertex index!");
+			}
+		}
+		return DaspGraph(graphseg::CreateCsrTopology(num_vertices, edges), std::move(points), std::move(weights));
 	}
 
 }
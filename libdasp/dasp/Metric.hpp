@@ -12,10 +12,37 @@
 #include <Danvil/Tools/MoreMath.h>
 #include <Danvil/Tools/FunctionCache.h>
 #include <Eigen/Dense>
+#include <vector>
 
 namespace dasp
 {
 
+	/** Point features in structure-of-arrays layout
+	 * Used by metrics which evaluate a batch of edges at once.
+	 */
+	struct PointFeatures
+	{
+		std::vector<float> position[3];
+		std::vector<float> color[3];
+		std::vector<float> normal[3];
+
+		void resize(unsigned int n) {
+			for(unsigned int i=0; i<3; i++) {
+				position[i].resize(n);
+				color[i].resize(n);
+				normal[i].resize(n);
+			}
+		}
+
+		void set(unsigned int k, const Point& p) {
+			for(unsigned int i=0; i<3; i++) {
+				position[i][k] = p.position[i];
+				color[i][k] = p.color[i];
+				normal[i][k] = p.normal[i];
+			}
+		}
+	};
+
 	namespace metric
 	{
 		inline int PixelDistanceSquared(const Point& a, const Point& b) {
@@ -58,6 +85,39 @@ namespace dasp
 			return 2.0f * q / (u.position.z() + v.position.z());
 		}
 
+		/** Endpoint features of a batch of edges in contiguous arrays
+		 * Edge k of the batch connects x and y with x_*[i][k] and y_*[i][k].
+		 */
+		struct EdgeBatch
+		{
+			static constexpr unsigned int cMaxSize = 256;
+
+			unsigned int size;
+			float x_pos[3][cMaxSize], y_pos[3][cMaxSize];
+			float x_col[3][cMaxSize], y_col[3][cMaxSize];
+			float x_norm[3][cMaxSize], y_norm[3][cMaxSize];
+
+			/** Gathers features for the edges (ea[k],eb[k]), k < n <= cMaxSize */
+			void gather(const PointFeatures& f, const unsigned int* ea, const unsigned int* eb, unsigned int n) {
+				size = n;
+				for(unsigned int i=0; i<3; i++) {
+					const float* pos = f.position[i].data();
+					const float* col = f.color[i].data();
+					const float* norm = f.normal[i].data();
+					for(unsigned int k=0; k<n; k++) {
+						const unsigned int a = ea[k];
+						const unsigned int b = eb[k];
+						x_pos[i][k] = pos[a];
+						y_pos[i][k] = pos[b];
+						x_col[i][k] = col[a];
+						y_col[i][k] = col[b];
+						x_norm[i][k] = norm[a];
+						y_norm[i][k] = norm[b];
+					}
+				}
+			}
+		};
+
 	}
 
 	/** Computes the density-adaptive distance from a point to a center point
@@ -174,6 +234,36 @@ namespace dasp
 			return exp_cache_(d_combined);
 		}
 
+		/** Computes the affinity for all edges of a batch (same as operator()) */
+		void evaluateBatch(const metric::EdgeBatch& b, float* out) const {
+			float d_combined[metric::EdgeBatch::cMaxSize];
+			// distances are computed on contiguous arrays which allows the compiler to vectorize
+			for(unsigned int k=0; k<b.size; k++) {
+				const float d0 = b.y_pos[0][k] - b.x_pos[0][k];
+				const float d1 = b.y_pos[1][k] - b.x_pos[1][k];
+				const float d2 = b.y_pos[2][k] - b.x_pos[2][k];
+				const float d_spatial = d0*d0 + d1*d1 + d2*d2;
+				float scl_d_spatial = std::max(0.0f, d_spatial * scl_spatial_ - 1.2f);
+				const float c0 = b.x_col[0][k] - b.y_col[0][k];
+				const float c1 = b.x_col[1][k] - b.y_col[1][k];
+				const float c2 = b.x_col[2][k] - b.y_col[2][k];
+				const float d_color = c0*c0 + c1*c1 + c2*c2;
+				float d_normal;
+				if(SupressConvexEdges) {
+					const float n0 = b.x_norm[0][k] - b.y_norm[0][k];
+					const float n1 = b.x_norm[1][k] - b.y_norm[1][k];
+					const float n2 = b.x_norm[2][k] - b.y_norm[2][k];
+					d_normal = (n0*d0 + n1*d1 + n2*d2) * Danvil::MoreMath::FastInverseSqrt(d_spatial);
+					d_normal = std::max(0.0f, d_normal);
+				}
+				else {
+					d_normal = 1.0f - (b.x_norm[0][k]*b.y_norm[0][k] + b.x_norm[1][k]*b.y_norm[1][k] + b.x_norm[2][k]*b.y_norm[2][k]);
+				}
+				d_combined[k] = scl_d_spatial + scl_color_*d_color + scl_normal_*d_normal;
+			}
+			exp_cache_(d_combined, out, b.size);
+		}
+
 	private:
 		static constexpr float cWeightRho = 0.01f; // 640x480 clusters would yield 0.1 which is used in gPb
 		unsigned int num_superpixels_;
@@ -181,7 +271,7 @@ namespace dasp
 		float scl_spatial_;
 		float scl_color_;
 		float scl_normal_;
-		Danvil::ExpNegFunctionCache<float> exp_cache_; // used for std::exp(-x)
+		Danvil::ExpNegFunctionCache<float> exp_cache_; // used for exp(-x)
 	};
 
 	struct ImprovedSpectralAffinity
@@ -198,12 +288,16 @@ namespace dasp
 		}
 
 		float operator()(const Cluster& x, const Cluster& y) const {
-			const Eigen::Vector3f& x_pos = x.center.position;
-			const Eigen::Vector3f& y_pos = y.center.position;
-			const Eigen::Vector3f& x_col = x.center.color;
-			const Eigen::Vector3f& y_col = y.center.color;
-			const Eigen::Vector3f& x_norm = x.center.normal;
-			const Eigen::Vector3f& y_norm = y.center.normal;
+			return (*this)(x.center, y.center);
+		}
+
+		float operator()(const Point& x, const Point& y) const {
+			const Eigen::Vector3f& x_pos = x.position;
+			const Eigen::Vector3f& y_pos = y.position;
+			const Eigen::Vector3f& x_col = x.color;
+			const Eigen::Vector3f& y_col = y.color;
+			const Eigen::Vector3f& x_norm = x.normal;
+			const Eigen::Vector3f& y_norm = y.normal;
 			// spatial distance
 			float dw = (x_pos - y_pos).squaredNorm() / (4.0f * superpixel_radius_ * superpixel_radius_);
 			dw = std::max(0.0f, dw - 1.2f); // distance of 1 indicates estimated distance
@@ -218,10 +312,34 @@ namespace dasp
 			return exp_cache_(d);
 		}
 
+		/** Computes the affinity for all edges of a batch (same as operator()) */
+		void evaluateBatch(const metric::EdgeBatch& b, float* out) const {
+			const float r2 = 4.0f * superpixel_radius_ * superpixel_radius_;
+			float d[metric::EdgeBatch::cMaxSize];
+			// distances are computed on contiguous arrays which allows the compiler to vectorize
+			for(unsigned int k=0; k<b.size; k++) {
+				const float u0 = b.y_pos[0][k] - b.x_pos[0][k];
+				const float u1 = b.y_pos[1][k] - b.x_pos[1][k];
+				const float u2 = b.y_pos[2][k] - b.x_pos[2][k];
+				const float uu = u0*u0 + u1*u1 + u2*u2;
+				const float dw = std::max(0.0f, uu / r2 - 1.2f);
+				const float c0 = b.x_col[0][k] - b.y_col[0][k];
+				const float c1 = b.x_col[1][k] - b.y_col[1][k];
+				const float c2 = b.x_col[2][k] - b.y_col[2][k];
+				const float dc = 3.2f * (c0*c0 + c1*c1 + c2*c2);
+				const float n0 = b.x_norm[0][k] - b.y_norm[0][k];
+				const float n1 = b.x_norm[1][k] - b.y_norm[1][k];
+				const float n2 = b.x_norm[2][k] - b.y_norm[2][k];
+				const float dn = std::max(0.0f, (n0*u0 + n1*u1 + n2*u2) / std::sqrt(uu));
+				d[k] = ww_*dw + wc_*dc + wn_*dn;
+			}
+			exp_cache_(d, out, b.size);
+		}
+
 	private:
 		float superpixel_radius_;
 		float ww_, wc_, wn_;
-		Danvil::ExpNegFunctionCache<float> exp_cache_; // used for std::exp(-x)
+		Danvil::ExpNegFunctionCache<float> exp_cache_; // used for exp(-x)
 	};	
 
 	struct ClassicSpectralAffinitySLIC
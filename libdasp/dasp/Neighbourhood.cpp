@@ -7,7 +7,9 @@
 
 #include "Neighbourhood.hpp"
 #include "Metric.hpp"
-#include <boost/graph/copy.hpp>
+#include <Danvil/Tools/Parallel.h>
+#include <unordered_map>
+#include <algorithm>
 #include <iostream>
 
 namespace dasp
@@ -16,68 +18,97 @@ namespace dasp
 DaspGraph CreateDaspNeighbourhoodGraph(const Superpixels& superpixels)
 {
 	NeighbourhoodGraph gnb = CreateNeighborhoodGraph(superpixels, NeighborGraphSettings::NoCut());
-	DaspGraph result;
-	boost::copy_graph(gnb, result,
-		boost::vertex_copy(
-			[&superpixels,&gnb,&result](UndirectedWeightedGraph::vertex_descriptor src, DaspGraph::vertex_descriptor dst) {
-				result[dst] = superpixels.cluster[src].center;
-			}
-		)
-		.edge_copy(
-			[&gnb,&result](UndirectedWeightedGraph::edge_descriptor src, DaspGraph::edge_descriptor dst) {
-				result[dst] = 1.0f;
-			}
-		)
-	);
-	return result;
+	std::vector<Point> centers(boost::num_vertices(gnb));
+	for(unsigned int i=0; i<centers.size(); i++) {
+		centers[i] = superpixels.cluster[i].center;
+	}
+	return DaspGraph(gnb.topology(), std::move(centers), std::vector<float>(boost::num_edges(gnb), 1.0f));
 }
 
 DaspGraph CreateDaspGraph(const Superpixels& superpixels, const UndirectedWeightedGraph& weighted_graph)
 {
-	DaspGraph result;
-	boost::copy_graph(weighted_graph, result,
-		boost::vertex_copy(
-			[&superpixels,&weighted_graph,&result](UndirectedWeightedGraph::vertex_descriptor src, DaspGraph::vertex_descriptor dst) {
-				result[dst] = superpixels.cluster[src].center;
-			}
-		)
-		.edge_copy(
-			[&weighted_graph,&result](UndirectedWeightedGraph::edge_descriptor src, DaspGraph::edge_descriptor dst) {
-				result[dst] = weighted_graph[src];
-			}
-		)
-	);
-	return result;
+	std::vector<Point> centers(boost::num_vertices(weighted_graph));
+	for(unsigned int i=0; i<centers.size(); i++) {
+		centers[i] = superpixels.cluster[i].center;
+	}
+	return DaspGraph(weighted_graph.topology(), std::move(centers), weighted_graph.edgeProperties());
 }
 
 DaspGraph ConvertToSimilarityGraph(const DaspGraph& source, const float sigma) {
-	DaspGraph result;
-	boost::copy_graph(source, result,
-			boost::edge_copy([&source,&result,sigma](typename DaspGraph::edge_descriptor src, DaspGraph::edge_descriptor dst) {
-				const float d = source[src];
-				const float s = std::exp(-d/sigma);
-				result[dst] = s;
-	}));
+	DaspGraph result = source;
+	for(float& w : result.edgeProperties()) {
+		w = std::exp(-w/sigma);
+	}
 	return result;
 }
 
-std::vector<unsigned int> ComputeAllBorderPixels(const Superpixels& superpixels)
+namespace impl
 {
-	slimage::Image1i labels = superpixels.ComputeLabels();
-	std::set<unsigned int> u;
-	int face_neighbours[] = { -1, +1, -labels.width(), +labels.width() };
-	for(unsigned int y=1; y<labels.height()-1; y++) {
-		for(unsigned int x=1; x<labels.width()-1; x++) {
-			int q = labels.index(x,y);
-			unsigned int lc = labels[q];
-			for(unsigned int i=0; i<4; i++) {
-				if(labels[q + face_neighbours[i]] != lc) {
-					u.insert(q);
+	/** Marks border pixels in rows [y_begin,y_end[ */
+	void MarkBorderRows(const int* labels, int w, int h, int y_begin, int y_end, bool include_image_border, BorderBitmap& border)
+	{
+		for(int y=y_begin; y<y_end; y++) {
+			if(y == 0 || y+1 == h) {
+				if(include_image_border) {
+					for(int x=0; x<w; x++) {
+						border.set(x + y*w);
+					}
+				}
+				continue;
+			}
+			if(include_image_border) {
+				border.set(y*w);
+				border.set(w - 1 + y*w);
+			}
+			for(int x=1; x+1<w; x++) {
+				const int q = x + y*w;
+				const int lc = labels[q];
+				if(labels[q-1] != lc || labels[q+1] != lc || labels[q-w] != lc || labels[q+w] != lc) {
+					border.set(q);
 				}
 			}
 		}
 	}
-	return std::vector<unsigned int>(u.begin(), u.end());
+
+	BorderBitmap ComputeBorderBitmap(const int* labels, int w, int h, bool include_image_border)
+	{
+		// bands of 64 rows start at a multiple of 64 pixels and thus never share a bitmap word
+		constexpr unsigned int cBandRows = 64;
+		BorderBitmap border(w, h);
+		Danvil::ParallelChunks(h, cBandRows,
+			[labels, w, h, include_image_border, &border](std::size_t, std::size_t begin, std::size_t end) {
+				MarkBorderRows(labels, w, h, begin, end, include_image_border, border);
+			});
+		return border;
+	}
+}
+
+BorderBitmap ComputeBorderBitmap(const slimage::Image1i& labels, bool include_image_border)
+{
+	std::vector<int> v(labels.size());
+	for(unsigned int i=0; i<v.size(); i++) {
+		v[i] = labels[i];
+	}
+	return impl::ComputeBorderBitmap(v.data(), labels.width(), labels.height(), include_image_border);
+}
+
+BorderBitmap ComputeBorderBitmap(const Superpixels& superpixels)
+{
+	const std::vector<int> labels = superpixels.ComputePixelLabels();
+	return impl::ComputeBorderBitmap(labels.data(), superpixels.width(), superpixels.height(), false);
+}
+
+std::vector<unsigned int> ComputeAllBorderPixels(const Superpixels& superpixels)
+{
+	return ComputeBorderBitmap(superpixels).indices();
+}
+
+void PlotBorderPixels(Eigen::MatrixXf& mat, const BorderBitmap& border, float value)
+{
+	float* p = mat.data();
+	border.forEach([p,value](unsigned int pid) {
+		p[pid] = value;
+	});
 }
 
 //std::vector<unsigned int> ComputeBorderPixels(const std::vector<unsigned int>& pixel_ids, unsigned int desired_neighbour_cid, const slimage::Image1i& labels)
@@ -101,112 +132,164 @@ std::vector<unsigned int> ComputeAllBorderPixels(const Superpixels& superpixels)
 //	return border;
 //}
 
-struct BorderPixel
+namespace impl
 {
-	unsigned int pixel_id;
-	unsigned int label;
-};
+	/** Superpixel border pixels found by scanning a band of image rows */
+	struct BorderScan
+	{
+		std::unordered_map<uint64_t,unsigned int> pair_index;
+		std::vector<std::pair<unsigned int,unsigned int>> pairs;
+		std::vector<std::vector<unsigned int>> pair_border;
+		std::vector<unsigned int> border_size;
+	};
 
-std::vector<BorderPixel> ComputeBorderLabels(unsigned int cid, const Superpixels& spc, const slimage::Image1i& labels)
-{
-	const int w = static_cast<int>(labels.width());
-	const int h = static_cast<int>(labels.height());
-	const int d[4] = { -1, +1, -w, +w };
-	std::vector<BorderPixel> border;
-	for(unsigned int pid : spc.cluster[cid].pixel_ids) {
-		int x = pid % w;
-		int y = pid / w;
-		if(1 <= x && x+1 < w && 1 <= y && y+1 < h) {
-			for(int i=0; i<4; i++) {
-				int label = labels[pid + d[i]];
-				if(label != cid && label != -1) {
-					border.push_back(BorderPixel{pid, label});
+	inline uint64_t PairKey(unsigned int a, unsigned int b) {
+		return (static_cast<uint64_t>(a) << 32) | static_cast<uint64_t>(b);
+	}
+
+	/** Finds border pixels in rows [y_begin,y_end[
+	 * A pixel is added once for each 4-neighbour with a different valid label.
+	 * Pixels on the image border are ignored.
+	 */
+	void ScanBorderRows(const std::vector<int>& labels, int w, int h, int y_begin, int y_end, unsigned int num_labels, BorderScan& scan)
+	{
+		scan.border_size.resize(num_labels, 0);
+		const int d[4] = { -1, +1, -w, +w };
+		uint64_t last_key = static_cast<uint64_t>(-1);
+		unsigned int last_index = 0;
+		for(int y=std::max(y_begin, 1); y<std::min(y_end, h-1); y++) {
+			for(int x=1; x+1<w; x++) {
+				const int q = x + y*w;
+				const int la = labels[q];
+				if(la == -1) {
+					continue;
+				}
+				for(int i=0; i<4; i++) {
+					const int lb = labels[q + d[i]];
+					if(lb == la || lb == -1) {
+						continue;
+					}
+					scan.border_size[la] ++;
+					const uint64_t key = (la < lb) ? PairKey(la, lb) : PairKey(lb, la);
+					if(key != last_key) {
+						auto it = scan.pair_index.insert(std::make_pair(key, scan.pairs.size()));
+						if(it.second) {
+							scan.pairs.push_back(std::make_pair(std::min(la, lb), std::max(la, lb)));
+							scan.pair_border.push_back(std::vector<unsigned int>());
+						}
+						last_key = key;
+						last_index = it.first->second;
+					}
+					scan.pair_border[last_index].push_back(q);
 				}
 			}
 		}
 	}
-	return border;
-}
 
-std::vector<std::vector<BorderPixel>> ComputeBorderLabels(const Superpixels& spc)
-{
-	slimage::Image1i labels = spc.ComputeLabels();
-	std::vector<std::vector<BorderPixel>> border_pixels(spc.cluster.size());
-	for(unsigned int cid=0; cid<spc.cluster.size(); cid++) {
-		border_pixels[cid] = ComputeBorderLabels(cid, spc, labels);
-	}
-	return border_pixels;
-}
-
-std::vector<unsigned int> FindCommonBorder(const std::vector<std::vector<BorderPixel>>& border, unsigned int cid, unsigned cjd) {
-	const std::vector<BorderPixel>& bi = border[cid];
-	const std::vector<BorderPixel>& bj = border[cjd];
-	std::vector<unsigned int> common;
-	common.reserve(bi.size() + bj.size());
-	for(const BorderPixel& q : bi) {
-		if(q.label == cjd) {
-			common.push_back(q.pixel_id);
-		}
-	}
-	for(const BorderPixel& q : bi) {
-		if(q.label == cjd) {
-			common.push_back(q.pixel_id);
+	/** Computes superpixel border pixels for all pairs of adjacent superpixels
+	 * Rows are scanned in parallel bands and merged in band order.
+	 */
+	BorderScan ScanBorders(const Superpixels& superpixels)
+	{
+		constexpr unsigned int cBandRows = 16;
+		const std::vector<int> labels = superpixels.ComputePixelLabels();
+		const int w = superpixels.width();
+		const int h = superpixels.height();
+		const unsigned int num_labels = superpixels.clusterCount();
+		std::vector<BorderScan> bands(Danvil::ChunkCount(h, cBandRows));
+		Danvil::ParallelChunks(h, cBandRows,
+			[&labels, w, h, num_labels, &bands](std::size_t k, std::size_t begin, std::size_t end) {
+				ScanBorderRows(labels, w, h, begin, end, num_labels, bands[k]);
+			});
+		// merge bands
+		BorderScan result;
+		result.border_size.resize(num_labels, 0);
+		for(BorderScan& band : bands) {
+			for(unsigned int i=0; i<band.pairs.size(); i++) {
+				const std::pair<unsigned int,unsigned int>& ab = band.pairs[i];
+				auto it = result.pair_index.insert(std::make_pair(PairKey(ab.first, ab.second), result.pairs.size()));
+				if(it.second) {
+					result.pairs.push_back(ab);
+					result.pair_border.push_back(std::move(band.pair_border[i]));
+				}
+				else {
+					std::vector<unsigned int>& dst = result.pair_border[it.first->second];
+					dst.insert(dst.end(), band.pair_border[i].begin(), band.pair_border[i].end());
+				}
+			}
+			for(unsigned int i=0; i<num_labels; i++) {
+				result.border_size[i] += band.border_size[i];
+			}
 		}
+		return result;
 	}
-	return common;
 }
 
 NeighbourhoodGraph CreateNeighborhoodGraph(const Superpixels& superpixels, NeighborGraphSettings settings)
 {
-	// create one node for each superpixel
-	NeighbourhoodGraph neighbourhood_graph(superpixels.clusterCount());
-	// compute superpixel borders
-	std::vector<std::vector<BorderPixel> > border = ComputeBorderLabels(superpixels);
+	// compute superpixel borders for all adjacent superpixels
+	impl::BorderScan border = impl::ScanBorders(superpixels);
+	// add edges in the order of superpixel ids
+	std::vector<unsigned int> order(border.pairs.size());
+	for(unsigned int k=0; k<order.size(); k++) {
+		order[k] = k;
+	}
+	std::sort(order.begin(), order.end(),
+		[&border](unsigned int a, unsigned int b) {
+			return border.pairs[a] < border.pairs[b];
+		});
 	// connect superpixels
 	const float spatial_distance_threshold = settings.spatial_distance_mult_threshold * superpixels.opt.base_radius;
 	const float pixel_distance_mult_threshold = settings.pixel_distance_mult_threshold;
-	for(unsigned int i=0; i<superpixels.cluster.size(); i++) {
-		for(unsigned int j=i+1; j<superpixels.cluster.size(); j++) {
-			const Point& c_i = superpixels.cluster[i].center;
-			const Point& c_j = superpixels.cluster[j].center;
-			// early test if the two superpixels are even near to each other
-			if(settings.cut_by_spatial) {
-				// spatial distance
-				float d = (c_i.position - c_j.position).norm();
-				// only test if distance is smaller than threshold
-				if(d > spatial_distance_threshold) {
-					continue;
-				}
-			}
-			else {
-				// pixel distance on camera image plane
-				float d = std::sqrt(static_cast<float>(metric::PixelDistanceSquared(c_i,c_j)));
-				// only test if pixel distance is smaller then C * pixel_radius
-				float r = std::max(c_i.cluster_radius_px, c_j.cluster_radius_px);
-				if(d > pixel_distance_mult_threshold * r) {
-					continue;
-				}
-			}
-			// compute intersection of border pixels
-			std::vector<unsigned int> common_border = FindCommonBorder(border, i, j);
-			// test if superpixels have a common border
-			unsigned int common_border_size = common_border.size();
-			if(common_border_size < settings.min_abs_border_overlap) {
+	std::vector<std::pair<unsigned int,unsigned int>> edges;
+	std::vector<NeighbourhoodProperties> edge_properties;
+	NeighbourhoodGraphProperties graph_properties;
+	for(unsigned int k : order) {
+		const unsigned int i = border.pairs[k].first;
+		const unsigned int j = border.pairs[k].second;
+		const Point& c_i = superpixels.cluster[i].center;
+		const Point& c_j = superpixels.cluster[j].center;
+		// test if the two superpixels are near to each other
+		if(settings.cut_by_spatial) {
+			// spatial distance
+			float d = (c_i.position - c_j.position).norm();
+			// only test if distance is smaller than threshold
+			if(d > spatial_distance_threshold) {
 				continue;
 			}
-			float p = static_cast<float>(common_border_size) / static_cast<float>(std::min(border[i].size(), border[j].size()));
-			if(p < settings.min_border_overlap) {
+		}
+		else {
+			// pixel distance on camera image plane
+			float d = std::sqrt(static_cast<float>(metric::PixelDistanceSquared(c_i,c_j)));
+			// only test if pixel distance is smaller then C * pixel_radius
+			float r = std::max(c_i.cluster_radius_px, c_j.cluster_radius_px);
+			if(d > pixel_distance_mult_threshold * r) {
 				continue;
 			}
-			// add edge
-			NeighbourhoodGraph::edge_descriptor eid;
-			bool ok;
-			boost::tie(eid,ok) = boost::add_edge(i, j, neighbourhood_graph); // FIXME correctly convert superpixel_id to vertex descriptor
-			assert(ok);
-			neighbourhood_graph[eid].num_border_pixels = common_border_size;
-			neighbourhood_graph[eid].border_pixel_ids = common_border;
 		}
+		// test if superpixels have a large enough common border
+		const std::vector<unsigned int>& common_border = border.pair_border[k];
+		unsigned int common_border_size = common_border.size();
+		if(common_border_size < settings.min_abs_border_overlap) {
+			continue;
+		}
+		float p = static_cast<float>(common_border_size) / static_cast<float>(std::min(border.border_size[i], border.border_size[j]));
+		if(p < settings.min_border_overlap) {
+			continue;
+		}
+		// add edge
+		edges.push_back(std::make_pair(i, j));
+		edge_properties.push_back(NeighbourhoodProperties{
+			common_border_size,
+			static_cast<unsigned int>(graph_properties.border_pixels.size())});
+		graph_properties.border_pixels.insert(graph_properties.border_pixels.end(), common_border.begin(), common_border.end());
 	}
+	// create one node for each superpixel
+	NeighbourhoodGraph neighbourhood_graph(
+		graphseg::CreateCsrTopology(superpixels.clusterCount(), edges),
+		std::vector<boost::no_property>(superpixels.clusterCount()),
+		std::move(edge_properties));
+	neighbourhood_graph[boost::graph_bundle] = std::move(graph_properties);
 	return neighbourhood_graph;
 }
 
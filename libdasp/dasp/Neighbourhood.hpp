@@ -10,17 +10,86 @@
 
 #include "Superpixels.hpp"
 #include "Graph.hpp"
+#include "Metric.hpp"
+#include <Danvil/Tools/Parallel.h>
 #include <slimage/image.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/copy.hpp>
 #include <Eigen/Dense>
+#include <type_traits>
+#include <cstdint>
 #include <vector>
 
 namespace dasp
 {
 
+	/** A pixel mask with one bit per pixel
+	 * Bit i corresponds to the pixel with index i = x + y*width.
+	 */
+	struct BorderBitmap
+	{
+		unsigned int width, height;
+		std::vector<uint64_t> bits;
+
+		BorderBitmap()
+		: width(0), height(0) {}
+
+		BorderBitmap(unsigned int w, unsigned int h)
+		: width(w), height(h), bits((static_cast<std::size_t>(w)*h + 63) / 64, 0) {}
+
+		bool test(unsigned int pid) const {
+			return (bits[pid >> 6] >> (pid & 63)) & 1;
+		}
+
+		bool test(unsigned int x, unsigned int y) const {
+			return test(x + y*width);
+		}
+
+		void set(unsigned int pid) {
+			bits[pid >> 6] |= static_cast<uint64_t>(1) << (pid & 63);
+		}
+
+		/** Number of set pixels */
+		unsigned int count() const {
+			unsigned int n = 0;
+			for(uint64_t b : bits) {
+				n += __builtin_popcountll(b);
+			}
+			return n;
+		}
+
+		/** Calls f(pid) for all set pixels in increasing order */
+		template<typename F>
+		void forEach(F f) const {
+			for(std::size_t k=0; k<bits.size(); k++) {
+				uint64_t b = bits[k];
+				while(b) {
+					f(static_cast<unsigned int>(64*k + __builtin_ctzll(b)));
+					b &= b - 1;
+				}
+			}
+		}
+
+		/** Sorted list of set pixel indices */
+		std::vector<unsigned int> indices() const {
+			std::vector<unsigned int> v;
+			v.reserve(count());
+			forEach([&v](unsigned int pid) { v.push_back(pid); });
+			return v;
+		}
+	};
+
+	/** Computes pixels which lie on the border between segments
+	 * A pixel is a border pixel if one of its 4-neighbours has a different label.
+	 * Pixels on the image border are only marked if include_image_border is set.
+	 * Rows are processed in parallel.
+	 * @param labels label image
+	 */
+	BorderBitmap ComputeBorderBitmap(const slimage::Image1i& labels, bool include_image_border=false);
+
+	/** Computes pixels which lie on the border between superpixels */
+	BorderBitmap ComputeBorderBitmap(const Superpixels& superpixels);
+
 	/** Computes points which lie on the border between segments
-	 * @param list of point indices
+	 * @param sorted list of point indices
 	 */
 	std::vector<unsigned int> ComputeAllBorderPixels(const Superpixels& superpixels);
 
@@ -46,44 +115,94 @@ namespace dasp
 	NeighbourhoodGraph CreateNeighborhoodGraph(const Superpixels& superpixels,
 		NeighborGraphSettings settings=NeighborGraphSettings::SpatialCut());
 
+	namespace impl
+	{
+		/** Tests if a metric provides evaluateBatch(const metric::EdgeBatch&, float*) */
+		template<typename Metric>
+		struct HasBatchEvaluation
+		{
+			template<typename M> static char test(decltype(&M::evaluateBatch));
+			template<typename M> static long test(...);
+			static constexpr bool value = (sizeof(test<Metric>(0)) == 1);
+		};
+
+		/** Evaluates the metric edge by edge in parallel chunks */
+		template<typename Metric>
+		void EvaluateEdgeMetric(const Superpixels& superpixels, const graphseg::CsrTopology& topology, const Metric& metric, float* weights, std::false_type)
+		{
+			Danvil::ParallelChunks(topology.numEdges(), metric::EdgeBatch::cMaxSize,
+				[&superpixels, &topology, &metric, weights](std::size_t, std::size_t begin, std::size_t end) {
+					for(std::size_t k=begin; k<end; k++) {
+						weights[k] = metric(
+							superpixels.cluster[topology.edge_source[k]].center,
+							superpixels.cluster[topology.edge_target[k]].center);
+					}
+				});
+		}
+
+		/** Evaluates the metric for batches of edges in parallel chunks
+		 * Superpixel center features are gathered once into contiguous arrays.
+		 */
+		template<typename Metric>
+		void EvaluateEdgeMetric(const Superpixels& superpixels, const graphseg::CsrTopology& topology, const Metric& metric, float* weights, std::true_type)
+		{
+			PointFeatures features;
+			features.resize(superpixels.cluster.size());
+			for(unsigned int i=0; i<superpixels.cluster.size(); i++) {
+				features.set(i, superpixels.cluster[i].center);
+			}
+			Danvil::ParallelChunks(topology.numEdges(), metric::EdgeBatch::cMaxSize,
+				[&features, &topology, &metric, weights](std::size_t, std::size_t begin, std::size_t end) {
+					metric::EdgeBatch batch;
+					batch.gather(features, &topology.edge_source[begin], &topology.edge_target[begin], end - begin);
+					metric.evaluateBatch(batch, weights + begin);
+				});
+		}
+	}
+
 	/** Computes edge weights for a superpixel graph using the given metric
-	 * Metric : Point x Point -> float (should be lightweight)
+	 * Metric : Point x Point -> float (should be lightweight and thread-safe)
+	 * Edges are evaluated in parallel. Metrics with a member function
+	 * evaluateBatch(const metric::EdgeBatch&, float*) are evaluated on batches
+	 * of edges and must give the same result as the per-edge operator().
+	 * The result shares the topology of graph (which must be a graphseg::CsrGraph).
 	 */
 	template<typename Graph, typename Metric>
 	UndirectedWeightedGraph ComputeEdgeWeights(const Superpixels& superpixels, const Graph& graph, const Metric& metric)
 	{
-		UndirectedWeightedGraph result;
-		boost::copy_graph(graph, result,
-			boost::edge_copy([&superpixels, &graph, &result, &metric](typename Graph::edge_descriptor src, UndirectedWeightedGraph::edge_descriptor dst) {
-				const unsigned int ea = boost::source(src, graph);
-				const unsigned int eb = boost::target(src, graph);
-				const float w = metric(superpixels.cluster[ea].center, superpixels.cluster[eb].center);
-				result[dst] = w;
-			}));
+		UndirectedWeightedGraph result(graph.topology());
+		impl::EvaluateEdgeMetric(superpixels, *graph.topology(), metric, result.edgeProperties().data(),
+			std::integral_constant<bool, impl::HasBatchEvaluation<Metric>::value>());
 		return result;
 	}
 
+	/** Computes edge weights using the metric weighted by the relative border length
+	 * Metric : unsigned int x unsigned int -> float (superpixel indices, should be thread-safe)
+	 */
 	template<typename Metric>
 	UndirectedWeightedGraph ComputeEdgeWeightsFromMetricWeighted(const Superpixels& superpixels, const NeighbourhoodGraph& graph, const Metric& metric)
 	{
+		const graphseg::CsrTopology& topology = *graph.topology();
+		const std::vector<NeighbourhoodProperties>& props = graph.edgeProperties();
 		std::vector<unsigned int> cluster_border_length_px(boost::num_vertices(graph));
-		for(auto eid : as_range(boost::edges(graph))) {
-			const unsigned int ea = boost::source(eid, graph);
-			const unsigned int eb = boost::target(eid, graph);
-			const unsigned int num = graph[eid].num_border_pixels;
-			cluster_border_length_px[ea] += num;
-			cluster_border_length_px[eb] += num;
+		for(unsigned int k=0; k<topology.numEdges(); k++) {
+			const unsigned int num = props[k].num_border_pixels;
+			cluster_border_length_px[topology.edge_source[k]] += num;
+			cluster_border_length_px[topology.edge_target[k]] += num;
 		}
-		UndirectedWeightedGraph result;
-		boost::copy_graph(graph, result,
-			boost::edge_copy([&superpixels, &graph, &result, &metric, &cluster_border_length_px](typename NeighbourhoodGraph::edge_descriptor src, UndirectedWeightedGraph::edge_descriptor dst) {
-				const unsigned int ea = boost::source(src, graph);
-				const unsigned int eb = boost::target(src, graph);
-				const float w = static_cast<float>(graph[src].num_border_pixels)
-					/ static_cast<float>(cluster_border_length_px[ea] + cluster_border_length_px[eb]);
-				const float d = metric(ea, eb);
-				result[dst] = 12.0f * w * d;
-			}));
+		UndirectedWeightedGraph result(graph.topology());
+		float* weights = result.edgeProperties().data();
+		Danvil::ParallelChunks(topology.numEdges(), metric::EdgeBatch::cMaxSize,
+			[&topology, &props, &cluster_border_length_px, &metric, weights](std::size_t, std::size_t begin, std::size_t end) {
+				for(std::size_t k=begin; k<end; k++) {
+					const unsigned int ea = topology.edge_source[k];
+					const unsigned int eb = topology.edge_target[k];
+					const float w = static_cast<float>(props[k].num_border_pixels)
+						/ static_cast<float>(cluster_border_length_px[ea] + cluster_border_length_px[eb]);
+					const float d = metric(ea, eb);
+					weights[k] = 12.0f * w * d;
+				}
+			});
 		return result;
 	}
 
@@ -100,23 +219,27 @@ namespace dasp
 	/** Computes a border image
 	 * All border pixels for each edge are set to the edge weight in the image.
 	 * Border pixels are given in index form x + y*w where w must be the same given as parameter.
-	 * @param graph a boost graph
-	 * @param weights an weight property map of type float
-	 * @param border_pixels an edge property map of type std::vector<unsigned int>
+	 * @param graph the neighbourhood graph
+	 * @param weights an edge weight property map of type float of a graph sharing the topology of graph
 	 * @param return image with painted border pixels
 	 */
-	template<typename Graph, typename WeightMap, typename BorderPixelMap>
-	void PlotBorderPixels(Eigen::MatrixXf& mat, const Graph& graph, WeightMap weights, BorderPixelMap border_pixels)
+	template<typename WeightMap>
+	void PlotBorderPixels(Eigen::MatrixXf& mat, const NeighbourhoodGraph& graph, WeightMap weights)
 	{
 		float* p = mat.data();
 		for(auto eid : as_range(boost::edges(graph))) {
 			float v = weights[eid];
-			for(unsigned int pid : boost::get(border_pixels, eid)) {
+			for(unsigned int pid : BorderPixelIds(graph, eid)) {
 				p[pid] = v;
 			}
 		}
 	}
 
+	/** Sets all border pixels in the image to the given value
+	 * Border pixels are given in index form x + y*w where w must be the same given as parameter.
+	 */
+	void PlotBorderPixels(Eigen::MatrixXf& mat, const BorderBitmap& border, float value);
+
 }
 
 #endif
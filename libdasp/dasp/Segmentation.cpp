@@ -42,6 +42,33 @@ std::vector<slimage::Pixel3ub> ComputeSegmentColors(const Superpixels& clusters,
 	return colors;
 }
 
+std::vector<int> ComputeClusterCorrespondence(const std::vector<Eigen::Vector2f>& previous_centers, const Superpixels& clusters)
+{
+	const int num_previous = static_cast<int>(previous_centers.size());
+	std::vector<int> correspondence(clusters.clusterCount(), -1);
+	for(unsigned int i=0; i<correspondence.size(); i++) {
+		const Cluster& c = clusters.cluster[i];
+		// superpixels seeded from the previous frame know their origin
+		if(clusters.opt.seed_mode == SeedModes::Delta) {
+			if(c.seed_id < num_previous) {
+				correspondence[i] = c.seed_id;
+			}
+			continue;
+		}
+		// otherwise use the nearest previous cluster center
+		const Eigen::Vector2f x(c.center.px, c.center.py);
+		float best_d2 = c.center.cluster_radius_px * c.center.cluster_radius_px;
+		for(int j=0; j<num_previous; j++) {
+			const float d2 = (previous_centers[j] - x).squaredNorm();
+			if(d2 < best_d2) {
+				best_d2 = d2;
+				correspondence[i] = j;
+			}
+		}
+	}
+	return correspondence;
+}
+
 slimage::Image3ub CreateLabelImage(const Superpixels& clusters, const graphseg::GraphLabeling& labeling, const std::vector<slimage::Pixel3ub>& colors)
 {
 	slimage::Image3ub vis_img(clusters.width(), clusters.height(), slimage::Pixel3ub{{0,0,0}});
@@ -14,8 +14,6 @@
 #include <graphseg/graphseg.hpp>
 #include <slimage/image.hpp>
 #include <Eigen/Dense>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/copy.hpp>
 #include <vector>
 #include <iostream>
 
@@ -31,30 +29,49 @@ std::vector<slimage::Pixel3ub> ComputeSegmentColors(const Superpixels& clusters,
 /** Creates an image where each superpixel is colored with the corresponding label color */
 slimage::Image3ub CreateLabelImage(const Superpixels& clusters, const graphseg::GraphLabeling& labeling, const std::vector<slimage::Pixel3ub>& colors);
 
-/** Performs spectral graph segmentation */
+/** Finds for each superpixel the corresponding superpixel of the previous frame
+ * Uses the seed origin if superpixels were seeded from the previous frame
+ * (SeedModes::Delta) and the nearest previous cluster center within the
+ * superpixel radius otherwise. Superpixels without partner get -1.
+ * @param previous_centers cluster centers of the previous frame (see Superpixels::getClusterCentersAsPoints)
+ */
+std::vector<int> ComputeClusterCorrespondence(const std::vector<Eigen::Vector2f>& previous_centers, const Superpixels& clusters);
+
+namespace detail
+{
+	/** Creates graph for spectral solving with the same topology */
+	template<typename SuperpixelGraph, typename WeightMap>
+	graphseg::SpectralGraph CreateSpectralGraph(const SuperpixelGraph& graph, WeightMap weights)
+	{
+		graphseg::SpectralGraph spectral(graph.topology());
+		for(auto eid : as_range(boost::edges(graph))) {
+			spectral[eid] = boost::get(weights, eid);
+		}
+		return spectral;
+	}
+}
+
+/** Performs spectral graph segmentation
+ * The result shares the topology of graph (which must be a graphseg::CsrGraph).
+ */
 template<typename SuperpixelGraph, typename WeightMap>
 UndirectedWeightedGraph SpectralSegmentation(const SuperpixelGraph& graph, WeightMap weights)
 {
-	// create graph for spectral solving
-	graphseg::SpectralGraph spectral;
-	boost::copy_graph(graph, spectral,
-			boost::edge_copy(
-				[&spectral,&weights](typename SuperpixelGraph::edge_descriptor src, typename graphseg::SpectralGraph::edge_descriptor dst) {
-					spectral[dst] = boost::get(weights, src);
-				}
-	));
 	// do spectral graph foo
-	graphseg::SpectralGraph solved = graphseg::SolveSpectral(spectral, 24);
-//	graphseg::SpectralGraph solved = graphseg::SolveMCL(spectral, 1.41f, 50);
-	// create superpixel neighbourhood graph with edge strength
-	UndirectedWeightedGraph result;
-	boost::copy_graph(solved, result,
-			boost::edge_copy(
-				[&solved,&result](typename graphseg::SpectralGraph::edge_descriptor src, typename UndirectedWeightedGraph::edge_descriptor dst) {
-					result[dst] = solved[src];
-				}
-	));
-	return result;
+	return graphseg::SolveSpectral(detail::CreateSpectralGraph(graph, weights), 24);
+//	return graphseg::SolveMCL(spectral, 1.41f, 50);
+}
+
+/** Performs spectral graph segmentation with the given solver
+ * Iterative solvers are started with initial_guess, e.g. the eigenvectors of
+ * the previous frame mapped with graphseg::MapSpectralSubspace and
+ * ComputeClusterCorrespondence. The computed eigenvectors are written to solution.
+ */
+template<typename SuperpixelGraph, typename WeightMap>
+UndirectedWeightedGraph SpectralSegmentation(const SuperpixelGraph& graph, WeightMap weights, graphseg::SpectralMethod method,
+	const graphseg::SpectralSubspace& initial_guess, graphseg::SpectralSubspace* solution)
+{
+	return graphseg::SolveSpectral(detail::CreateSpectralGraph(graph, weights), 24, method, initial_guess, solution);
 }
 
 }
@@ -456,8 +456,6 @@ label_pixel_invalid_omg:
 void Superpixels::ComputeSuperpixels(const std::vector<Seed>& seeds)
 {
 
-	SetRandomNumberSeed(opt.random_seed);
-
 //	std::cout << "DASP START" << std::endl;
 //	std::cout << "Density total = " << density.sum() << ", seed points = " << seeds.size() << std::endl;
 	CreateClusters(seeds);
@@ -722,19 +720,20 @@ std::vector<Seed> CreateSeedPoints(
 
 std::vector<Seed> Superpixels::FindSeeds()
 {
+	pds::Rng rng(opt.random_seed);
 	switch(opt.seed_mode) {
 	case SeedModes::Random:
 		return CreateSeedPoints(points,
-			pds::Random(density));
+			pds::Random(rng, density));
 	case SeedModes::Grid:
 		return CreateSeedPoints(points,
 			pds::RectGrid(density));
 	case SeedModes::SimplifiedPDS_Old:
 		return CreateSeedPoints(points,
-			pds::SimplifiedPDSOld(density));
+			pds::SimplifiedPDSOld(rng, density));
 	case SeedModes::SimplifiedPDS:
 		return CreateSeedPoints(points,
-			pds::SimplifiedPDS(density));
+			pds::SimplifiedPDS(rng, density));
 	case SeedModes::FloydSteinberg:
 		return CreateSeedPoints(points,
 			pds::FloydSteinberg(density));
@@ -743,10 +742,10 @@ std::vector<Seed> Superpixels::FindSeeds()
 			pds::FloydSteinbergExpo(density));
 	case SeedModes::FloydSteinbergMultiLayer:
 		return CreateSeedPoints(points,
-			pds::FloydSteinbergMultiLayer(density));
+			pds::FloydSteinbergMultiLayer(rng, density));
 	case SeedModes::Fattal:
 		return CreateSeedPoints(points,
-			pds::Fattal(density));
+			pds::Fattal(rng, density));
 	case SeedModes::Delta: {
 		std::vector<Eigen::Vector2f> pnts_prev(cluster.size());
 		for(std::size_t i=0; i<cluster.size(); i++) {
@@ -754,7 +753,7 @@ std::vector<Seed> Superpixels::FindSeeds()
 			pnts_prev[i] = Eigen::Vector2f(c.center.px, c.center.py);
 		}
 		std::vector<int> seed_origin;
-		std::vector<Eigen::Vector2f> pnts = pds::DeltaDensitySampling(density, pnts_prev, &seed_origin);
+		std::vector<Eigen::Vector2f> pnts = pds::DeltaDensitySampling(rng, density, pnts_prev, &seed_origin);
 		std::vector<Seed> seeds = CreateSeedPoints(points, pnts, &seed_origin);
 		assert(seeds.size() != seed_origin.size());
 		if(seeds.size() != seed_origin.size()) {
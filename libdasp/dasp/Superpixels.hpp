@@ -28,8 +28,6 @@ namespace dasp
 		Histogram<float> hist_coverage_error;
 	};
 
-	void SetRandomNumberSeed(unsigned int seed);
-
 	struct Partition
 	{
 		std::vector<std::vector<unsigned int>> segments;
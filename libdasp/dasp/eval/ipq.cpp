@@ -1,5 +1,6 @@
 #include "eval.hpp"
 #include <dasp/Superpixels.hpp>
+#include <dasp/Neighbourhood.hpp>
 #include <boost/math/constants/constants.hpp>
 #include <iostream>
 
@@ -44,24 +45,6 @@ float Area3D(const Superpixels& u)
 	return std::accumulate(sp_area.begin(), sp_area.end(), 0.0f) / static_cast<float>(sp_area.size());
 }
 
-slimage::Image1i MarkBoundary(const slimage::Image1i& labels)
-{
-	slimage::Image1i boundary(labels.dimensions(), slimage::Pixel1i{1});
-	for(unsigned int y=1; y+1<boundary.height(); y++) {
-		for(unsigned int x=1; x+1<boundary.width(); x++) {
-			int q = labels(x, y);
-			int qp0 = labels(x+1, y  );
-			int qm0 = labels(x-1, y  );
-			int q0p = labels(x  , y+1);
-			int q0m = labels(x  , y-1);
-			if(q == qp0 && q == qm0 && q == q0p && q == q0m) {
-				boundary(x,y) = 0;
-			}
-		}
-	}
-	return boundary;
-}
-
 template<typename K>
 std::pair<float,std::vector<float>> IsoperimetricQuotientImpl(const std::vector<std::pair<K,K>>& sp_area_length)
 {
@@ -87,8 +70,8 @@ std::pair<float,std::vector<float>> IsoperimetricQuotient(const Superpixels& u)
 {
 	// compute labels
 	slimage::Image1i labels = u.ComputeLabels();
-	// compute boundary image
-	slimage::Image1i boundary = MarkBoundary(labels);
+	// compute boundary pixels (pixels on the image border count as boundary)
+	const BorderBitmap boundary = ComputeBorderBitmap(labels, true);
 	// compute total pixel count and number of boundary pixels for each cluster
 	std::vector<std::pair<int,int>> ipq_els(u.clusterCount(), {0,0});
 	for(std::size_t i=0; i<labels.size(); i++) {
@@ -96,7 +79,7 @@ std::pair<float,std::vector<float>> IsoperimetricQuotient(const Superpixels& u)
 		if(label == -1) {
 			continue;
 		}
-		if(boundary[i] == 1) {
+		if(boundary.test(i)) {
 			ipq_els[label].second ++;
 		}
 		else {
@@ -111,8 +94,8 @@ std::pair<float,std::vector<float>> IsoperimetricQuotient3D(const Superpixels& u
 {
 	// compute labels
 	slimage::Image1i labels = u.ComputeLabels();
-	// compute boundary image
-	slimage::Image1i boundary = MarkBoundary(labels);
+	// compute boundary pixels (pixels on the image border count as boundary)
+	const BorderBitmap boundary = ComputeBorderBitmap(labels, true);
 	// compute total pixel count and number of boundary pixels for each cluster
 	std::vector<std::pair<float,float>> ipq_els(u.clusterCount(), {0.0f,0.0f});
 //	std::vector<std::vector<std::size_t>> seg_bnd(u.clusterCount());
@@ -130,7 +113,7 @@ std::pair<float,std::vector<float>> IsoperimetricQuotient3D(const Superpixels& u
 		// compute pixel area
 		ipq_els[label].first += px_area;
 		// compute pixel diameter
-		if(boundary[i] == 1) {
+		if(boundary.test(i)) {
 //			seg_bnd[label].push_back(i);
 			ipq_els[label].second += px_len;
 		}
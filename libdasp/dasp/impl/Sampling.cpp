@@ -9,11 +9,9 @@
 #include <common/color.hpp>
 #include "Sampling.hpp"
 #include "../Superpixels.hpp"
-#include <pds/Tools.hpp>
 #include <density/ScalePyramid.hpp>
 #include <slimage/algorithm.hpp>
 #include <functional>
-#include <boost/random.hpp>
 #include <boost/math/constants/constants.hpp>
 #include <cmath>
 
@@ -202,13 +200,6 @@ void AdaptClusterRadiusBySaliency(ImagePoints& points, const Eigen::MatrixXf& sa
 	}
 }
 
-//------------------------------------------------------------------------------
-
-void SetRandomNumberSeed(unsigned int x)
-{
-	pds::impl::RndSeed(x);
-}
-
 //------------------------------------------------------------------------------
 }
 //------------------------------------------------------------------------------
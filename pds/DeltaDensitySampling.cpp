@@ -3,6 +3,8 @@
 #include "Tools.hpp"
 #include <density/ScalePyramid.hpp>
 #include <density/PointDensity.hpp>
+#include <algorithm>
+#include <limits>
 #include <iostream>
 
 //#define VERBOSE
@@ -10,7 +12,115 @@
 namespace pds
 {
 
+	namespace
+	{
+		/** Uniform grid over seeds for nearest seed queries
+		 * Cells have about the size of the mean seed distance. Removed seeds are
+		 * swapped with the last seed of their cell, so removal is O(1).
+		 */
+		class SeedGrid
+		{
+		public:
+			SeedGrid(const std::vector<Eigen::Vector2f>& seeds, int width, int height)
+			:	seeds_(seeds), num_(seeds.size()) {
+				// about one seed per cell
+				cell_size_ = std::max(1.0f, std::sqrt(static_cast<float>(width*height) / static_cast<float>(std::max<std::size_t>(num_, 1))));
+				nx_ = std::max(1, static_cast<int>(std::ceil(static_cast<float>(width) / cell_size_)));
+				ny_ = std::max(1, static_cast<int>(std::ceil(static_cast<float>(height) / cell_size_)));
+				cells_.resize(nx_*ny_);
+				index_in_cell_.resize(seeds.size());
+				for(unsigned int i=0; i<seeds.size(); i++) {
+					std::vector<unsigned int>& c = cells_[cellIndex(seeds[i])];
+					index_in_cell_[i] = c.size();
+					c.push_back(i);
+				}
+			}
+
+			bool empty() const {
+				return num_ == 0;
+			}
+
+			/** Index of the seed nearest to p (seed with smallest index for ties)
+			 * The grid must not be empty.
+			 */
+			unsigned int nearest(const Eigen::Vector2f& p) const {
+				const int cx = cellX(p[0]);
+				const int cy = cellY(p[1]);
+				float d_min = std::numeric_limits<float>::max();
+				unsigned int i_min = 0;
+				bool found = false;
+				// visit rings of cells around the cell of p
+				const int r_max = std::max(nx_, ny_);
+				for(int r=0; r<=r_max; r++) {
+					// seeds in ring r are at least (r-1) cells away
+					const float d_ring = static_cast<float>(r - 1) * cell_size_;
+					if(found && r > 1 && d_ring*d_ring > d_min) {
+						break;
+					}
+					auto visit = [this, &p, &d_min, &i_min, &found](int x, int y) {
+						if(x < 0 || nx_ <= x || y < 0 || ny_ <= y) {
+							return;
+						}
+						for(unsigned int i : cells_[x + nx_*y]) {
+							const float d = (p - seeds_[i]).squaredNorm();
+							if(d < d_min || (d == d_min && i < i_min)) {
+								d_min = d;
+								i_min = i;
+								found = true;
+							}
+						}
+					};
+					if(r == 0) {
+						visit(cx, cy);
+						continue;
+					}
+					for(int x=cx-r; x<=cx+r; x++) {
+						visit(x, cy - r);
+						visit(x, cy + r);
+					}
+					for(int y=cy-r+1; y<=cy+r-1; y++) {
+						visit(cx - r, y);
+						visit(cx + r, y);
+					}
+				}
+				return i_min;
+			}
+
+			/** Removes the seed with index i */
+			void remove(unsigned int i) {
+				std::vector<unsigned int>& c = cells_[cellIndex(seeds_[i])];
+				const unsigned int last = c.back();
+				c[index_in_cell_[i]] = last;
+				index_in_cell_[last] = index_in_cell_[i];
+				c.pop_back();
+				num_--;
+			}
+
+		private:
+			int cellX(float x) const {
+				return std::min(nx_ - 1, std::max(0, static_cast<int>(std::floor(x / cell_size_))));
+			}
+
+			int cellY(float y) const {
+				return std::min(ny_ - 1, std::max(0, static_cast<int>(std::floor(y / cell_size_))));
+			}
+
+			int cellIndex(const Eigen::Vector2f& p) const {
+				return cellX(p[0]) + nx_*cellY(p[1]);
+			}
+
+		private:
+			const std::vector<Eigen::Vector2f>& seeds_;
+			std::size_t num_;
+			float cell_size_;
+			int nx_, ny_;
+			std::vector<std::vector<unsigned int>> cells_;
+			std::vector<unsigned int> index_in_cell_;
+		};
+	}
+
 	std::vector<Eigen::Vector2f> DeltaDensitySampling(
+		Rng& rng,
 		const Eigen::MatrixXf& dnew,
 		const std::vector<Eigen::Vector2f>& seeds_old,
 		std::vector<int>* seed_origin)
@@ -20,27 +130,31 @@ namespace pds
 		sDebugImages["seeds_delta"] = slimage::Ptr(debug);
 	#endif
 		// compute old density
-		Eigen::MatrixXf dprev = density::PointDensity(seeds_old, dnew);
+		Eigen::MatrixXf dprev = density::PointDensitySeparable(seeds_old, dnew);
 #ifdef VERBOSE
 		std::cout << "DDS: seeds_old.size()=" << seeds_old.size() << std::endl;
 #endif
-		// delta density
-		Eigen::MatrixXf ddelta = dnew - dprev;
-		Eigen::MatrixXf ddelta_abs = ddelta.cwiseAbs();
-		Eigen::MatrixXf dsub = 0.5f * (ddelta_abs - ddelta);
+		// delta density split into negative and positive part
+		// dsub = 0.5*(|dnew - dprev| - (dnew - dprev)) and dadd = 0.5*(|dnew - dprev| + (dnew - dprev))
+		Eigen::MatrixXf dsub(dnew.rows(), dnew.cols());
+		Eigen::MatrixXf dadd(dnew.rows(), dnew.cols());
+		for(int i=0; i<dnew.size(); i++) {
+			const float d = dnew.data()[i] - dprev.data()[i];
+			dsub.data()[i] = std::max(0.0f, -d);
+			dadd.data()[i] = std::max(0.0f, d);
+		}
 #ifdef VERBOSE
 		std::cout << "DDS: dsub.sum()=" << dsub.sum() << std::endl;
 #endif
-		Eigen::MatrixXf dadd = 0.5f * (ddelta_abs + ddelta);
 #ifdef VERBOSE
 		std::cout << "DDS: dadd.sum()=" << dadd.sum() << std::endl;
 #endif
 		// sample points
-		std::vector<Eigen::Vector2f> psub = SimplifiedPDS(dsub);
+		std::vector<Eigen::Vector2f> psub = SimplifiedPDS(rng, dsub);
 #ifdef VERBOSE
 		std::cout << "DDS: psub.size()=" << psub.size() << std::endl;
 #endif
-		std::vector<Eigen::Vector2f> padd = SimplifiedPDS(dadd);
+		std::vector<Eigen::Vector2f> padd = SimplifiedPDS(rng, dadd);
 #ifdef VERBOSE
 		std::cout << "DDS: padd.size()=" << padd.size() << std::endl;
 #endif
@@ -49,29 +163,31 @@ namespace pds
 		// 	padd.clear();
 		// }
 
-		// remove points
-		std::vector<Eigen::Vector2f> samples = seeds_old;
-		if(seed_origin) {
-			*seed_origin = std::vector<int>(samples.size());
-			for(size_t i=0; i<seed_origin->size(); ++i) {
-				(*seed_origin)[i] = i;
+		// remove the old seed nearest to each point
+		std::vector<unsigned char> is_removed(seeds_old.size(), 0);
+		SeedGrid grid(seeds_old, dnew.rows(), dnew.cols());
+		for(const Eigen::Vector2f& p : psub) {
+			if(grid.empty()) {
+				break;
 			}
+			const unsigned int i = grid.nearest(p);
+			grid.remove(i);
+			is_removed[i] = 1;
 		}
-		// TODO: this is O(N*M) and slow
-		for(const Eigen::Vector2f& p : psub) {
-			float d_min = (p - samples.front()).squaredNorm();
-			auto it_min = samples.begin();
-			for(auto it=samples.begin(); it!=samples.end(); ++it) {
-				float d = (p - *it).squaredNorm();
-				if(d < d_min) {
-					d_min = d;
-					it_min = it;
+		// remaining old seeds keep their order
+		std::vector<Eigen::Vector2f> samples;
+		samples.reserve(seeds_old.size() + padd.size());
+		if(seed_origin) {
+			seed_origin->clear();
+			seed_origin->reserve(seeds_old.size() + padd.size());
+		}
+		for(std::size_t i=0; i<seeds_old.size(); i++) {
+			if(!is_removed[i]) {
+				samples.push_back(seeds_old[i]);
+				if(seed_origin) {
+					seed_origin->push_back(i);
 				}
 			}
-			samples.erase(it_min);
-			if(seed_origin) {
-				seed_origin->erase(seed_origin->begin() + std::distance(samples.begin(), it_min));
-			}
 		}
 		// add points
 		samples.insert(samples.end(), padd.begin(), padd.end());
@@ -13,7 +13,7 @@ namespace pds
 		constexpr float GAMMA = 0.38f;
 
 		template<unsigned int Q>
-		void FindSeedsDeltaMipmap_Walk(std::vector<Eigen::Vector2f>& seeds,
+		void FindSeedsDeltaMipmap_Walk(Rng& rng, std::vector<Eigen::Vector2f>& seeds,
 			const std::vector<Eigen::MatrixXf>& mipmaps_value,
 			const std::vector<Eigen::MatrixXf>& mipmaps_delta,
 			const std::vector<Eigen::MatrixXf>& mipmaps_delta_abs,
@@ -21,9 +21,6 @@ namespace pds
 		{
 			constexpr float BREAK_SMOOTH = 2.0f;
 
-			static boost::uniform_real<float> rnd(0.0f, 1.0f);
-			static boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(impl::Rnd(), rnd);
-
 			const Eigen::MatrixXf& mm_v = mipmaps_value[level];
 			const Eigen::MatrixXf& mm_s = mipmaps_delta[level];
 			const Eigen::MatrixXf& mm_a = mipmaps_delta_abs[level];
@@ -40,10 +37,10 @@ namespace pds
 				//|| (std::abs(v_sum) - v_abs) / (std::abs(v_sum) + v_abs)
 			) {
 				// go down
-				FindSeedsDeltaMipmap_Walk<Q>(seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x,     2*y    );
-				FindSeedsDeltaMipmap_Walk<Q>(seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x,     2*y + 1);
-				FindSeedsDeltaMipmap_Walk<Q>(seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x + 1, 2*y    );
-				FindSeedsDeltaMipmap_Walk<Q>(seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x + 1, 2*y + 1);
+				FindSeedsDeltaMipmap_Walk<Q>(rng, seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x,     2*y    );
+				FindSeedsDeltaMipmap_Walk<Q>(rng, seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x,     2*y + 1);
+				FindSeedsDeltaMipmap_Walk<Q>(rng, seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x + 1, 2*y    );
+				FindSeedsDeltaMipmap_Walk<Q>(rng, seeds, mipmaps_value, mipmaps_delta, mipmaps_delta_abs, level - 1, 2*x + 1, 2*y + 1);
 			}
 			else {
 				// const float brok = std::abs(v_sum_abs - v_abs) / (v_sum_abs + v_abs);
@@ -53,7 +50,7 @@ namespace pds
 				// if(brok > 0.5f) {
 				// 	return;
 				// }
-				if(die() < v_sum_abs)
+				if(rng.uniform01() < v_sum_abs)
 				{
 					const Eigen::MatrixXf& mmd0 = mipmaps_delta[0];
 
@@ -88,7 +85,7 @@ namespace pds
 						}
 						// add seed to middle of cell
 						if(best_i != -1 && best_j != -1) {
-							seeds.push_back(impl::RandomCellPoint(Q, x0 + best_j, y0 + best_i, GAMMA));
+							seeds.push_back(impl::RandomCellPoint(rng, Q, x0 + best_j, y0 + best_i, GAMMA));
 		#ifdef CREATE_DEBUG_IMAGES
 							for(unsigned int i=0; i<2; i++) {
 								for(unsigned int j=0; j<2; j++) {
@@ -137,7 +134,7 @@ namespace pds
 			}
 		}
 
-		std::vector<Eigen::Vector2f> FindSeedsDelta(const std::vector<Eigen::Vector2f>& old_seeds, const Eigen::MatrixXf& density_old, const Eigen::MatrixXf& density_new)
+		std::vector<Eigen::Vector2f> FindSeedsDelta(Rng& rng, const std::vector<Eigen::Vector2f>& old_seeds, const Eigen::MatrixXf& density_old, const Eigen::MatrixXf& density_new)
 		{
 			// difference
 			Eigen::MatrixXf density_delta = density_new - density_old;
@@ -155,14 +152,14 @@ namespace pds
 			const unsigned int l0 = mm_dv.size() - 1;
 			for(unsigned int y=0; y<mm_dv[l0].cols(); ++y) {
 				for(unsigned int x=0; x<mm_dv[l0].rows(); x++) {
-					FindSeedsDeltaMipmap_Walk<5>(seeds, mm_v, mm_dv, mm_da, l0, x, y);
+					FindSeedsDeltaMipmap_Walk<5>(rng, seeds, mm_v, mm_dv, mm_da, l0, x, y);
 				}
 			}
 			return seeds;
 		}
 	}
 
-	std::vector<Eigen::Vector2f> DeltaDensitySamplingOld(const Eigen::MatrixXf& density_new, const std::vector<Eigen::Vector2f>& old_seeds)
+	std::vector<Eigen::Vector2f> DeltaDensitySamplingOld(Rng& rng, const Eigen::MatrixXf& density_new, const std::vector<Eigen::Vector2f>& old_seeds)
 	{
 	#ifdef CREATE_DEBUG_IMAGES
 		slimage::Image3ub debug(points.width(), points.height(), {{0,0,0}});
@@ -171,7 +168,7 @@ namespace pds
 		// compute old density
 		Eigen::MatrixXf density_old = density::PointDensity(old_seeds, density_new);
 		// use function
-		return dds::FindSeedsDelta(old_seeds, density_old, density_new);
+		return dds::FindSeedsDelta(rng, old_seeds, density_old, density_new);
 	}
 
 }
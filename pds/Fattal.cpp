@@ -9,7 +9,8 @@
 
 #include "Fattal.hpp"
 #include <density/ScalePyramid.hpp>
-#include <boost/random.hpp>
+#include <Danvil/Tools/Parallel.h>
+#include <iostream>
 #ifdef DEBUG_SAVE_POINTS
 	#include <boost/format.hpp>
 	#include <fstream>
@@ -26,6 +27,22 @@ constexpr bool MH_TEST = false;
 constexpr float STEPSIZE = 0.3f;
 constexpr float TEMPERATURE = 0.03f;
 
+/** Radius of the kernel window relative to the kernel scale
+ * range = sqrt(ln(1/eps)/pi) with eps = 0.001
+ */
+constexpr float KERNEL_WINDOW_RANGE = 1.482837414f;
+
+/** Largest movement of a point in one Langevin step relative to the kernel scale
+ * Langevin steps are typically below 0.1 times the scale, larger moves are rejected.
+ */
+constexpr float REFINE_MOVE_MARGIN = 0.25f;
+
+/** Points are refined in bands of kernel scales (s_max/REFINE_SCALE_BAND, s_max] */
+constexpr float REFINE_SCALE_BAND = 2.0f;
+
+/** Refinement phases with fewer points are processed without worker threads */
+constexpr unsigned REFINE_MIN_PARALLEL = 32;
+
 float EnergyApproximation(const std::vector<Point>& pnts, float x, float y)
 {
 	float sum = 0.0f;
@@ -41,32 +58,72 @@ float EnergyApproximation(const std::vector<Point>& pnts, float x, float y)
 	return sum;
 }
 
+/** Pixels [x_min,x_max] x [y_min,y_max] where the kernel of a point is relevant */
+struct KernelWindow
+{
+	int x_min, x_max;
+	int y_min, y_max;
+};
+
+KernelWindow ComputeKernelWindow(const Point& p, int rows, int cols)
+{
+	const float radius = KERNEL_WINDOW_RANGE * p.scale;
+	return KernelWindow{
+		std::max(0, int(std::floor(p.x - radius))),
+		std::min(rows - 1, int(std::ceil(p.x + radius))),
+		std::max(0, int(std::floor(p.y - radius))),
+		std::min(cols - 1, int(std::ceil(p.y + radius)))
+	};
+}
+
+/** Calls f(x, y, value) for all pixels (x,y) in [0,rows[ x [0,cols[ where the kernel of p is relevant
+ * Kernel values are evaluated for 8 pixels of a row at once.
+ */
+template<typename F>
+void ForEachKernelValue(const Point& p, int rows, int cols, F f)
+{
+	const float px = p.x;
+	const float py = p.y;
+	const float scl = p.scale * p.scale;
+	const float pw_scl = p.weight / scl;
+	const float arg_scl = cPi / scl;
+	const KernelWindow w = ComputeKernelWindow(p, rows, cols);
+	const int x_min = w.x_min;
+	const int x_max = w.x_max;
+	const int y_min = w.y_min;
+	const int y_max = w.y_max;
+	float arg[8];
+	float val[8];
+	for(int y=y_min; y<=y_max; y++) {
+		const float dy = float(y) - py;
+		for(int x=x_min; x<=x_max; x+=8) {
+			for(int i=0; i<8; i++) {
+				const float dx = float(x + i) - px;
+				arg[i] = arg_scl * (dx*dx + dy*dy);
+			}
+			Danvil::ExpNeg8(arg, val);
+			const int n = std::min(8, x_max + 1 - x);
+			for(int i=0; i<n; i++) {
+				f(x + i, y, pw_scl * val[i]);
+			}
+		}
+	}
+}
+
+/** Adds the kernel of p multiplied with a to the density approximation */
+void AddKernel(Eigen::MatrixXf& approx, const Point& p, float a=1.0f)
+{
+	ForEachKernelValue(p, approx.rows(), approx.cols(),
+		[&approx, a](int x, int y, float k) {
+			approx(x,y) += a * k;
+		});
+}
+
 Eigen::MatrixXf EnergyApproximationMat(const std::vector<Point>& pnts, int rows, int cols)
 {
 	Eigen::MatrixXf mat = Eigen::MatrixXf::Constant(rows, cols, 0.0f);
 	for(const Point& p : pnts) {
-		float px = p.x;
-		float py = p.y;
-		float pw = p.weight;
-		float ps = p.scale;
-		float scl = p.scale * p.scale;
-		constexpr float cMaxRange = 1.482837414f; // eps = 0.001
-		float radius = cMaxRange * ps;
-		float x_min = std::max(0, int(std::floor(px - radius)));
-		float x_max = std::min(int(mat.rows()) - 1, int(std::ceil(px + radius)));
-		float y_min = std::max(0, int(std::floor(py - radius)));
-		float y_max = std::min(int(mat.cols()) - 1, int(std::ceil(py + radius)));
-		// sum over window
-		for(unsigned int y=y_min; y<=y_max; y++) {
-			for(unsigned int x=x_min; x<=x_max; x++) {
-				float ux = float(x);
-				float uy = float(y);
-				float dx = ux - px;
-				float dy = uy - py;
-				float d2 = dx*dx + dy*dy;
-				mat(x,y) += pw / scl * KernelFunctorSquare(d2 / scl);
-			}
-		}
+		AddKernel(mat, p);
 	}
 	return mat;
 	// Eigen::MatrixXf mat(rows, cols);
@@ -97,66 +154,69 @@ float Energy(const std::vector<Point>& pnts, const Eigen::MatrixXf& density)
 	// return error;
 }
 
-float EnergyDerivative(const std::vector<Point>& pnts, const Eigen::MatrixXf& density, unsigned int i, float& result_dE_x, float& result_dE_y)
+float EnergyDerivative(const Eigen::MatrixXf& approx, const Eigen::MatrixXf& density, const Point& p, float& result_dE_x, float& result_dE_y)
 {
 	float dE_x = 0.0f;
 	float dE_y = 0.0f;
-
-	const Point& pi = pnts[i];
-	float px = pi.x;
-	float py = pi.y;
-	float ps = pi.scale;
-	float ps_scl = 1.0f / (ps * ps);
-	// find window (points outside the window do not affect the kernel)
-	// range = sqrt(ln(1/eps)/pi)
-	constexpr float cMaxRange = 1.482837414f; // eps = 0.001
-	float radius = cMaxRange * ps;
-	float x_min = std::max(0, int(std::floor(px - radius)));
-	float x_max = std::min(int(density.rows()) - 1, int(std::ceil(px + radius)));
-	float y_min = std::max(0, int(std::floor(py - radius)));
-	float y_max = std::min(int(density.cols()) - 1, int(std::ceil(py + radius)));
-	// sum over window
-	for(unsigned int y=y_min; y<=y_max; y++) {
-		for(unsigned int x=x_min; x<=x_max; x++) {
-			float ux = float(x);
-			float uy = float(y);
-			float dx = ux - px;
-			float dy = uy - py;
-//			float k_arg = std::sqrt(dx*dx + dy*dy) * ps_scl;
-//			float k_val = KernelFunctor(k_arg);
-			float k_arg_square = (dx*dx + dy*dy) * ps_scl;
-			float k_val = KernelFunctorSquare(k_arg_square);
-			float apx = EnergyApproximation(pnts, ux, uy);
-			float roh = density(x, y);
-			if(apx < roh) {
+	// sum over window (points outside the window do not affect the kernel)
+	ForEachKernelValue(p, density.rows(), density.cols(),
+		[&approx, &density, &p, &dE_x, &dE_y](int x, int y, float k_val) {
+			if(approx(x,y) < density(x,y)) {
 				k_val = -k_val;
 			}
-			//k_val = 0.0f;
-			dE_x += k_val * dx;
-			dE_y += k_val * dy;
-		}
-	}
-	float A = 2.0f * cPi / std::pow(ps, float(D + 1));
+			dE_x += k_val * (float(x) - p.x);
+			dE_y += k_val * (float(y) - p.y);
+		});
+	// kernel values include the factor weight/scale^2
+	float ps = p.scale;
+	float A = 2.0f * cPi / std::pow(ps, float(D + 1)) * ps * ps / p.weight;
 	result_dE_x = A * dE_x;
 	result_dE_y = A * dE_y;
-	return radius;
+	return KERNEL_WINDOW_RANGE * ps;
+}
+
+float EnergyChange(const Eigen::MatrixXf& approx, const Eigen::MatrixXf& density, const Point& p_old, const Point& p_new)
+{
+	// only pixels in the kernel windows of the old and the new point change
+	const KernelWindow w_old = ComputeKernelWindow(p_old, density.rows(), density.cols());
+	const KernelWindow w_new = ComputeKernelWindow(p_new, density.rows(), density.cols());
+	const int x0 = std::min(w_old.x_min, w_new.x_min);
+	const int y0 = std::min(w_old.y_min, w_new.y_min);
+	const int nx = std::max(w_old.x_max, w_new.x_max) + 1 - x0;
+	const int ny = std::max(w_old.y_max, w_new.y_max) + 1 - y0;
+	const auto roh = density.block(x0, y0, nx, ny);
+	const auto apx = approx.block(x0, y0, nx, ny);
+	Eigen::MatrixXf apx_new = apx;
+	ForEachKernelValue(p_old, density.rows(), density.cols(),
+		[&apx_new, x0, y0](int x, int y, float k) {
+			apx_new(x - x0, y - y0) -= k;
+		});
+	ForEachKernelValue(p_new, density.rows(), density.cols(),
+		[&apx_new, x0, y0](int x, int y, float k) {
+			apx_new(x - x0, y - y0) += k;
+		});
+	return (apx_new - roh).cwiseAbs().sum() - (apx - roh).cwiseAbs().sum();
 }
 
-std::vector<Point> PlacePoints(const Eigen::MatrixXf& density, unsigned int p)
+std::vector<Point> PlacePoints(Rng& rng, const Eigen::MatrixXf& density, unsigned int p)
 {
 	// access original index in a random order
 	std::vector<unsigned int> indices(density.size());
 	for(unsigned int i=0; i<indices.size(); i++) {
 		indices[i] = i;
 	}
-	std::random_shuffle(indices.begin(), indices.end());
+	for(unsigned int i=indices.size(); i>1; i--) {
+		std::swap(indices[i-1], indices[rng.uniformInt(i)]);
+	}
 
 	// compute points
 	std::vector<Point> pnts;
 	pnts.reserve(indices.size());
-	// compute current error in density
-	float error_current = Energy(pnts, density);
-//	std::cout << "INITIAL ERROR: " << error_current << std::endl;
+	// current density approximation
+	// a point only changes the approximation and the energy inside of its kernel window
+	const int rows = density.rows();
+	const int cols = density.cols();
+	Eigen::MatrixXf approx = Eigen::MatrixXf::Zero(rows, cols);
 	// try add kernel points
 	for(unsigned int i : indices) {
 		float roh = density.data()[i];
@@ -170,18 +230,26 @@ std::vector<Point> PlacePoints(const Eigen::MatrixXf& density, unsigned int p)
 		int q = p - (roh < 1 ? 0 : std::ceil(std::log2(roh) / float(D)));
 		u.weight = float(1 << (D*(p-q)));
 		u.scale = KernelScaleFunction(roh, u.weight);
-		// try to add
-		pnts.push_back(u);
+		// change of the energy if the point is added
+		float error_delta = 0.0f;
+		ForEachKernelValue(u, rows, cols,
+			[&approx, &density, &error_delta](int x, int y, float k) {
+				const float a = approx(x,y);
+				const float r = density(x,y);
+				error_delta += std::abs(a + k - r) - std::abs(a - r);
+			});
 		// check if the points reduced the energy
-		float error_new = Energy(pnts, density);
-		if(error_new > error_current) {
+		if(error_delta > 0.0f) {
 			// reject
-			pnts.pop_back();
-//			std::cout << u.x << " " << u.y << " " << u.weight << " " << error_new << " REJECTED" << std::endl;
+//			std::cout << u.x << " " << u.y << " " << u.weight << " " << error_delta << " REJECTED" << std::endl;
 		}
 		else {
-			error_current = error_new;
-//			std::cout << u.x << " " << u.y << " " << u.weight << " " << error_new << std::endl;
+			pnts.push_back(u);
+			ForEachKernelValue(u, rows, cols,
+				[&approx](int x, int y, float k) {
+					approx(x,y) += k;
+				});
+//			std::cout << u.x << " " << u.y << " " << u.weight << " " << error_delta << std::endl;
 		}
 	}
 
@@ -191,83 +259,160 @@ std::vector<Point> PlacePoints(const Eigen::MatrixXf& density, unsigned int p)
 	return pnts;
 }
 
-void Refine(std::vector<Point>& points, const Eigen::MatrixXf& density, unsigned int iterations)
+/** One Langevin step for the point p with respect to the density approximation approx
+ * The move is rejected if the kernel window of the moved point is not inside
+ * the circle with radius reach around the old position.
+ * @return true if the point moved to p_new
+ */
+bool RefinePoint(Rng rng, const Eigen::MatrixXf& approx, const Eigen::MatrixXf& density, const Point& p, float reach, Point& p_new)
 {
-	static boost::mt19937 rng;
-	static boost::normal_distribution<float> rnd(0.0f, 1.0f); // standard normal distribution
-	static boost::variate_generator<boost::mt19937&, boost::normal_distribution<float> > die(rng, rnd);
-//	float r_min = 1e9;
-//	float r_max = 0;
-	for(unsigned int k=0; k<iterations; k++) {
-		float energy;
-		if(MH_TEST) {
-			energy = Energy(points, density);
+	if(p.scale > cMaxRefinementScale) {
+		// omit low frequency kernels
+		return false;
+	}
+	// random vector
+	float rndx = rng.normal();
+	float rndy = rng.normal();
+	// compute next position
+	// dx = -STEPSIZE*s/2*dE + sqrt(TEMPERATURE*s*STEPSIZE)*rnd()
+	float c0 = STEPSIZE * p.scale;
+	float cA = c0 * 0.5f;
+	float dx, dy;
+	EnergyDerivative(approx, density, p, dx, dy);
+	p_new = p;
+	p_new.x -= cA * dx;
+	p_new.y -= cA * dy;
+	float cB = std::sqrt(TEMPERATURE * c0);
+	p_new.x += cB * rndx;
+	p_new.y += cB * rndy;
+	float roh = ZeroBorderAccess(density, p_new.x, p_new.y);
+	if(roh > 0) {
+		p_new.scale = KernelScaleFunction(roh, p_new.weight);
+	}
+	else {
+		// reject
+		return false;
+	}
+	const float mx = p_new.x - p.x;
+	const float my = p_new.y - p.y;
+	if(std::sqrt(mx*mx + my*my) + KERNEL_WINDOW_RANGE*p_new.scale > reach) {
+		// reject as the point could interact with other points of its phase
+		return false;
+	}
+	// check if we want to keep the point
+	if(MH_TEST) {
+		float dxn, dyn;
+		EnergyDerivative(approx, density, p_new, dxn, dyn);
+		float h = cB / (2.0f*TEMPERATURE);
+		float hx = h*(dx + dxn) + rndx;
+		float hy = h*(dy + dyn) + rndy;
+		float g1 = -0.5f*(hx*hx + hy*hy);
+		float g2 = -0.5f*(rndx*rndx + rndy*rndy);
+		float P = std::exp(-EnergyChange(approx, density, p, p_new)/TEMPERATURE + g1 - g2);
+		return rng.uniform01() <= P;
+	}
+	return true;
+}
+
+/** Points which are refined at the same time
+ * A point only reads and changes the approximation inside of the circle with
+ * radius reach around its position.
+ */
+struct RefinementPhase
+{
+	std::vector<unsigned int> points;
+	float reach;
+};
+
+/** Groups points into phases of a refinement step
+ * Points are grouped into bands of similar kernel scales. Points of a band are
+ * sorted into grid cells with the size of the reach of the largest scale in
+ * the band. Each phase contains at most one point of each cell and only cells
+ * of one of 3x3 colours. Thus points of one phase are at least two times the
+ * reach apart and can be moved at the same time (see RefinePoint).
+ */
+std::vector<RefinementPhase> RefinementPhases(const std::vector<Point>& points, int rows, int cols)
+{
+	std::vector<std::vector<unsigned int>> bands;
+	for(unsigned int i=0; i<points.size(); i++) {
+		const float scale = points[i].scale;
+		if(scale <= cMaxRefinementScale) {
+			const unsigned int b = static_cast<unsigned int>(std::log(cMaxRefinementScale / scale) / std::log(REFINE_SCALE_BAND));
+			if(bands.size() <= b) {
+				bands.resize(b + 1);
+			}
+			bands[b].push_back(i);
 		}
-#ifdef VERBOSE
-		if(!MH_TEST) {
-			energy = Energy(points, density);
+	}
+	std::vector<RefinementPhase> phases;
+	for(unsigned int b=0; b<bands.size(); b++) {
+		if(bands[b].empty()) {
+			continue;
 		}
-		std::cout << "\tit=" << k << ", e=" << energy << std::endl;
-#endif
-		for(unsigned int i=0; i<points.size(); i++) {
-			// random vector
-			float rndx = die();
-			float rndy = die();
-			// compute next position
-			Point p = points[i];
-			if(p.scale > cMaxRefinementScale) {
-				// omit low frequency kernels
-				continue;
-			}
-			// dx = -STEPSIZE*s/2*dE + sqrt(TEMPERATURE*s*STEPSIZE)*rnd()
-			float c0 = STEPSIZE * p.scale;
-			float cA = c0 * 0.5f;
-			float dx, dy;
-			float R = EnergyDerivative(points, density, i, dx, dy);
-//			std::cout << i << ": (" << dx << "," << dy << "), s=" << p.scale << std::endl;
-//			r_min = std::min(R, r_min);
-//			r_max = std::max(R, r_max);
-//			std::cout << i << " p1: (" << p.x << "," << p.y << ")" << std::endl;
-			p.x -= cA * dx;
-			p.y -= cA * dy;
-			float cB = std::sqrt(TEMPERATURE * c0);
-			p.x += cB * rndx;
-			p.y += cB * rndy;
-			float roh = ZeroBorderAccess(density, p.x, p.y);
-			if(roh > 0) {
-				p.scale = KernelScaleFunction(roh, p.weight);
-			}
-			else {
-				// reject
-				continue;
-			}
-//			std::cout << i << " p2: (" << p.x << "," << p.y << ")" << std::endl;
-			// check if we want to keep the point
-			points[i] = p;
-			if(MH_TEST) {
-				Point pold = p;
-				float dxn, dyn;
-				EnergyDerivative(points, density, i, dxn, dyn);
-				float h = cB / (2.0f*TEMPERATURE);
-				float hx = h*(dx + dxn) + rndx;
-				float hy = h*(dy + dyn) + rndy;
-				float g1 = -0.5f*(hx*hx + hy*hy);
-				float g2 = -0.5f*(rndx*rndx + rndy*rndy);
-				float energy_new = Energy(points,density);
-				float P = std::exp((energy-energy_new)/TEMPERATURE + g1 - g2);
-//				std::cout << energy << " -> " << energy_new << ", P=" << P << std::endl;
-				if(die() <= P) {
-					// accept
-					energy = energy_new;
+		const float scale_max = cMaxRefinementScale / std::pow(REFINE_SCALE_BAND, float(b));
+		const float reach = (KERNEL_WINDOW_RANGE + REFINE_MOVE_MARGIN) * scale_max;
+		const int nx = int(float(rows) / reach) + 1;
+		const int ny = int(float(cols) / reach) + 1;
+		std::vector<std::vector<unsigned int>> cells(nx * ny);
+		for(unsigned int i : bands[b]) {
+			const Point& p = points[i];
+			// points slightly outside of the density are put into border cells
+			const int cx = std::min(nx - 1, std::max(0, int(p.x / reach)));
+			const int cy = std::min(ny - 1, std::max(0, int(p.y / reach)));
+			cells[cx + nx*cy].push_back(i);
+		}
+		for(int color=0; color<9; color++) {
+			std::vector<RefinementPhase> color_phases;
+			for(int cy=color/3; cy<ny; cy+=3) {
+				for(int cx=color%3; cx<nx; cx+=3) {
+					const std::vector<unsigned int>& cell = cells[cx + nx*cy];
+					if(color_phases.size() < cell.size()) {
+						color_phases.resize(cell.size(), RefinementPhase{{}, reach});
+					}
+					for(std::size_t k=0; k<cell.size(); k++) {
+						color_phases[k].points.push_back(cell[k]);
+					}
 				}
-				else {
-					// reject
-					points[i] = pold;
+			}
+			phases.insert(phases.end(), color_phases.begin(), color_phases.end());
+		}
+	}
+	return phases;
+}
+
+void Refine(Rng& rng, std::vector<Point>& points, const Eigen::MatrixXf& density, unsigned int iterations)
+{
+	// density approximation of the current points
+	// a point only changes the approximation inside of its kernel window
+	Eigen::MatrixXf approx = EnergyApproximationMat(points, density.rows(), density.cols());
+	std::vector<Point> points_new(points.size());
+	std::vector<unsigned char> is_moved(points.size());
+	for(unsigned int k=0; k<iterations; k++) {
+#ifdef VERBOSE
+		std::cout << "\tit=" << k << ", e=" << (approx - density).cwiseAbs().sum() << std::endl;
+#endif
+		// one random number stream per point, so the result does not depend on the number of threads
+		const Rng step_rng = rng.stream(rng());
+		// points of a phase do not interact and are moved in parallel
+		for(const RefinementPhase& phase : RefinementPhases(points, density.rows(), density.cols())) {
+			const std::vector<unsigned int>& phase_points = phase.points;
+			const float reach = phase.reach;
+			Danvil::ParallelFor(phase_points.size(),
+				[&phase_points, reach, &points, &points_new, &is_moved, &approx, &density, &step_rng](std::size_t j) {
+					const unsigned int i = phase_points[j];
+					is_moved[i] = RefinePoint(step_rng.stream(i), approx, density, points[i], reach, points_new[i]);
+				},
+				16, (phase_points.size() < REFINE_MIN_PARALLEL) ? 1 : Danvil::ThreadCount());
+			// update the approximation with the kernels of moved points
+			for(unsigned int i : phase_points) {
+				if(is_moved[i]) {
+					AddKernel(approx, points[i], -1.0f);
+					AddKernel(approx, points_new[i]);
+					points[i] = points_new[i];
 				}
 			}
 		}
 	}
-//	std::cout << r_min << " " << r_max << std::endl;
 }
 
 std::vector<Point> Split(const std::vector<Point>& points, const Eigen::MatrixXf& density, bool& result_added)
@@ -319,7 +464,7 @@ void SavePoints(const std::vector<Point>& pnt, const std::string& filename)
 }
 #endif
 
-std::vector<Point> Compute(const Eigen::MatrixXf& density)
+std::vector<Point> Compute(Rng& rng, const Eigen::MatrixXf& density)
 {
 #ifdef DEBUG_SAVE_POINTS
 	boost::format fn_fmt("pnt_%1%_%2%.tsv");
@@ -335,7 +480,7 @@ std::vector<Point> Compute(const Eigen::MatrixXf& density)
 		bool need_refinement;
 		if(i == p) {
 			// place initial points
-			pnts = PlacePoints(mipmaps[i], i);
+			pnts = PlacePoints(rng, mipmaps[i], i);
 			need_refinement = true;
 		}
 		else {
@@ -346,11 +491,11 @@ std::vector<Point> Compute(const Eigen::MatrixXf& density)
 //		if(need_refinement) {
 #ifdef DEBUG_SAVE_POINTS
 			for(int k=0; k<(i+1)*LANGEVIN_STEPS; k++) {
-				Refine(pnts, mipmaps[i], 1);
+				Refine(rng, pnts, mipmaps[i], 1);
 				SavePoints(pnts, (fn_fmt % i % k).str());
 			}
 #else
-			Refine(pnts, mipmaps[i], LANGEVIN_STEPS);
+			Refine(rng, pnts, mipmaps[i], LANGEVIN_STEPS);
 #endif
 //		}
 #ifdef VERBOSE
@@ -414,9 +559,9 @@ void PlotPoints(const std::vector<Point>& points, const slimage::Image3ub& img,
 
 //----------------------------------------------------------------------------//
 
-std::vector<Eigen::Vector2f> Fattal(const Eigen::MatrixXf& density)
+std::vector<Eigen::Vector2f> Fattal(Rng& rng, const Eigen::MatrixXf& density)
 {
-	std::vector<fattal::Point> pnts = fattal::Compute(density);
+	std::vector<fattal::Point> pnts = fattal::Compute(rng, density);
 	std::vector<Eigen::Vector2f> v(pnts.size());
 	std::transform(pnts.begin(), pnts.end(), v.begin(),
 		[](const fattal::Point& p) {
@@ -8,8 +8,9 @@
 #ifndef BLUENOISE_HPP_
 #define BLUENOISE_HPP_
 //----------------------------------------------------------------------------//
+#include "Rng.hpp"
 #include <slimage/image.hpp>
-#include <Danvil/Tools/FunctionCache.h>
+#include <Danvil/Tools/FastExp.h>
 #include <Eigen/Dense>
 #include <vector>
 #include <algorithm>
@@ -35,12 +36,6 @@ namespace fattal
 
 	constexpr float cPi = 3.141592654f;
 
-	/** phi(x) = exp(-pi*x*x) */
-	inline
-	float KernelFunctorImpl(float d) {
-		return std::exp(-cPi*d*d);
-	}
-
 	/**
 	 * Warning: only defined for y <= 1!
 	 */
@@ -48,21 +43,15 @@ namespace fattal
 		return std::sqrt(- std::log(y) / cPi);
 	}
 
+	/** phi(x) = exp(-pi*x*x) */
 	inline
 	float KernelFunctor(float d) {
-		static Danvil::FunctionCache<float,1> cache(0.0f, KernelRange, &KernelFunctorImpl);
-		return cache(std::abs(d));
-	}
-
-	inline
-	float KernelFunctorSquareImpl(float d) {
-		return std::exp(-cPi*d);
+		return Danvil::ExpNeg(cPi*d*d);
 	}
 
 	inline
 	float KernelFunctorSquare(float d) {
-		static Danvil::FunctionCache<float,1> cache(0.0f, KernelRange*KernelRange, &KernelFunctorSquareImpl);
-		return cache(d);
+		return Danvil::ExpNeg(cPi*d);
 	}
 
 	inline
@@ -96,15 +85,19 @@ namespace fattal
 
 	float Energy(const std::vector<Point>& pnts, const Eigen::MatrixXf& density);
 
-	float EnergyDerivative(const std::vector<Point>& pnts, const Eigen::MatrixXf& density, unsigned int i, float& result_dE_x, float& result_dE_y);
+	/** Derivative of the energy for the point p where approx is the current density approximation */
+	float EnergyDerivative(const Eigen::MatrixXf& approx, const Eigen::MatrixXf& density, const Point& p, float& result_dE_x, float& result_dE_y);
+
+	/** Change of the energy if the point p_old is moved to p_new */
+	float EnergyChange(const Eigen::MatrixXf& approx, const Eigen::MatrixXf& density, const Point& p_old, const Point& p_new);
 
-	std::vector<Point> PlacePoints(const Eigen::MatrixXf& density, unsigned int p);
+	std::vector<Point> PlacePoints(Rng& rng, const Eigen::MatrixXf& density, unsigned int p);
 
-	void Refine(std::vector<Point>& points, const Eigen::MatrixXf& density, unsigned int iterations);
+	void Refine(Rng& rng, std::vector<Point>& points, const Eigen::MatrixXf& density, unsigned int iterations);
 
 	std::vector<Point> Split(const std::vector<Point>& points, const Eigen::MatrixXf& density, bool& result_added);
 
-	std::vector<Point> Compute(const Eigen::MatrixXf& density);
+	std::vector<Point> Compute(Rng& rng, const Eigen::MatrixXf& density);
 
 	struct Color {
 		unsigned char r,g,b;
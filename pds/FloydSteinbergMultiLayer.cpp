@@ -2,41 +2,54 @@
 #include "PDS.hpp"
 #include "Tools.hpp"
 #include <density/ScalePyramid.hpp>
+#include <algorithm>
 
 namespace pds
 {
 
 	namespace mlfs
 	{
+		/** Finest level used for seeds (level 1 has half resolution) */
+		constexpr int cFinestLevel = 1;
 
-		void WriteMipmap(std::vector<Eigen::MatrixXf>& mipmaps, int level, int x, int y, float d)
+		/** Adds d to the element (level,x,y) and distributes it to the covered elements of finer levels
+		 * Elements which only partially cover the image get a share proportional to their covered area.
+		 */
+		void WriteMipmap(density::ScalePyramid& mipmaps, int level, int x, int y, float d)
 		{
-			// mipmaps[level](x,y) += d;
-			for(int k=level,s=1; k>=0; k--,s*=2) {
-				Eigen::MatrixXf& mm = mipmaps[k];
-				const float ds = d / static_cast<float>(s*s);
-				for(int i=0; i<s; i++) {
-					for(int j=0; j<s; j++) {
-						mm(x+j,y+i) += ds;
+			// mipmaps(level,x,y) += d;
+			const float area = static_cast<float>(mipmaps.cellWidth(level, x) * mipmaps.cellHeight(level, y));
+			for(int k=level,s=1; k>=cFinestLevel; k--,s*=2) {
+				const float ds = d / area;
+				const unsigned int x1 = std::min<unsigned int>((x+1)*s, mipmaps.width(k));
+				const unsigned int y1 = std::min<unsigned int>((y+1)*s, mipmaps.height(k));
+				// only the last element of a row or column can be partial
+				const float full = static_cast<float>(1 << k);
+				Eigen::Map<Eigen::MatrixXf> mm = mipmaps.level(k);
+				for(unsigned int i=y*s; i<y1; i++) {
+					const float dsi = ds * static_cast<float>(mipmaps.cellHeight(k, i));
+					mm.col(i).segment(x*s, x1 - x*s).array() += dsi * full;
+					if(x1 == mipmaps.width(k)) {
+						mm(x1 - 1, i) += dsi * (static_cast<float>(mipmaps.cellWidth(k, x1 - 1)) - full);
 					}
 				}
 			}
 		}
 
 		void FindSeedsDepthMipmapFS_Walk(
+				Rng& rng,
 				std::vector<Eigen::Vector2f>& seeds,
-				std::vector<Eigen::MatrixXf>& mipmaps,
+				density::ScalePyramid& mipmaps,
 				int level, unsigned int x, unsigned int y)
 		{
-			Eigen::MatrixXf& mm = mipmaps[level];
-
 			// compute density by multiplying percentage with parent total
-			float v = mm(x, y);
+			float v = mipmaps(level, x, y);
 
-			if(level == 0 || v <= 1.5f) {
+			if(level == cFinestLevel || v <= 1.5f) {
 				if(v >= 0.5f) {
 					seeds.push_back(
-						impl::RandomCellPoint(1 << level, x, y, 0.38f));
+						impl::RandomRectPoint(rng, x << level, y << level,
+							mipmaps.cellWidth(level, x), mipmaps.cellHeight(level, y), 0.38f));
 					// reduce density
 					v -= 1.0f;
 				}
@@ -48,8 +61,8 @@ namespace pds
 				// with range test *sigh*
 				float q = 0.0f;
 				bool xm1ok = (0 < x);
-				bool xp1ok = (x+1 < mm.rows());
-				bool yp1ok = (y+1 < mm.cols());
+				bool xp1ok = (x+1 < mipmaps.width(level));
+				bool yp1ok = (y+1 < mipmaps.height(level));
 				if(xp1ok) 			q += 7.0f;
 				if(yp1ok) {
 					if(xm1ok) 		q += 3.0f;			
@@ -67,57 +80,34 @@ namespace pds
 		//		}
 			}
 			else {
-				// go down
-				FindSeedsDepthMipmapFS_Walk(seeds, mipmaps, level - 1, 2*x,     2*y    );
-				FindSeedsDepthMipmapFS_Walk(seeds, mipmaps, level - 1, 2*x,     2*y + 1);
-				FindSeedsDepthMipmapFS_Walk(seeds, mipmaps, level - 1, 2*x + 1, 2*y    );
-				FindSeedsDepthMipmapFS_Walk(seeds, mipmaps, level - 1, 2*x + 1, 2*y + 1);
+				// go down (children outside of the image have no density)
+				for(unsigned int i=0; i<4; i++) {
+					const unsigned int cx = 2*x + (i/2);
+					const unsigned int cy = 2*y + (i%2);
+					if(mipmaps.valid(level - 1, cx, cy)) {
+						FindSeedsDepthMipmapFS_Walk(rng, seeds, mipmaps, level - 1, cx, cy);
+					}
+				}
 			}
 		}
 
-		std::vector<Eigen::Vector2f> FindSeedsDepthMipmapFS(const Eigen::MatrixXf& density)
+		std::vector<Eigen::Vector2f> FindSeedsDepthMipmapFS(Rng& rng, const Eigen::MatrixXf& density)
 		{
 			// compute mipmaps
-			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps(density, 1);
-		// #ifdef CREATE_DEBUG_IMAGES
-		// 	DebugMipmap<2>(mipmaps, "mmfs");
-		// #endif
+			density::ScalePyramid mipmaps(density);
 			// now create pixel seeds
 			std::vector<Eigen::Vector2f> seeds;
-			FindSeedsDepthMipmapFS_Walk( seeds, mipmaps, mipmaps.size() - 1, 0, 0);
-			impl::ScalePoints(seeds, 2.f);
-			return seeds;
-		}
-
-		std::vector<Eigen::Vector2f> FindSeedsDepthMipmapFS640(const Eigen::MatrixXf& density)
-		{
-			// compute mipmaps
-			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps640x480(density);
-		#ifdef CREATE_DEBUG_IMAGES
-			DebugMipmap<5>(mipmaps, "mmfs640");
-		#endif
-			// now create pixel seeds
-			std::vector<Eigen::Vector2f> seeds;
-			const unsigned int l0 = mipmaps.size() - 1;
-			for(unsigned int y=0; y<mipmaps[l0].cols(); ++y) {
-				for(unsigned int x=0; x<mipmaps[l0].rows(); x++) {
-					FindSeedsDepthMipmapFS_Walk(seeds, mipmaps, l0, x, y);
-				}
+			if(mipmaps.numLevels() > cFinestLevel) {
+				FindSeedsDepthMipmapFS_Walk(rng, seeds, mipmaps, mipmaps.numLevels() - 1, 0, 0);
 			}
-			impl::ScalePoints(seeds, 5.f);
 			return seeds;
 		}
 
 	}
 
-	std::vector<Eigen::Vector2f> FloydSteinbergMultiLayer(const Eigen::MatrixXf& density)
+	std::vector<Eigen::Vector2f> FloydSteinbergMultiLayer(Rng& rng, const Eigen::MatrixXf& density)
 	{
-		if(density.rows() == 640 && density.cols() == 480) {
-			return mlfs::FindSeedsDepthMipmapFS640(density);
-		}
-		else {
-			return mlfs::FindSeedsDepthMipmapFS(density);
-		}
+		return mlfs::FindSeedsDepthMipmapFS(rng, density);
 	}
 
 }
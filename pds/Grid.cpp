@@ -5,16 +5,12 @@
 
 namespace pds {
 
-std::vector<Eigen::Vector2f> Random(const Eigen::MatrixXf& density)
+std::vector<Eigen::Vector2f> Random(Rng& rng, const Eigen::MatrixXf& density)
 {
-	boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(
-		impl::Rnd(),
-		boost::uniform_real<float>(0.0f, 1.0f));
-
 	std::vector<Eigen::Vector2f> seeds;
 	for(unsigned int iy=0; iy<density.cols(); iy++) {
 		for(unsigned int ix=0; ix<density.rows(); ix++) {
-			if(die() < density(ix,iy))
+			if(rng.uniform01() < density(ix,iy))
 				seeds.push_back(Eigen::Vector2f(ix, iy));
 		}
 	}
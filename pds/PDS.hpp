@@ -1,45 +1,51 @@
 #ifndef INCLUDED_PDS_PDS_HPP
 #define INCLUDED_PDS_PDS_HPP
 
+#include "Rng.hpp"
 #include <Eigen/Dense>
+#include <string>
 #include <vector>
 
 namespace pds
 {
 
-	std::vector<Eigen::Vector2f> Random(const Eigen::MatrixXf& density);
+	std::vector<Eigen::Vector2f> Random(Rng& rng, const Eigen::MatrixXf& density);
 
 	std::vector<Eigen::Vector2f> RectGrid(const Eigen::MatrixXf& density);
 
 	std::vector<Eigen::Vector2f> HexGrid(const Eigen::MatrixXf& density);
 
-	std::vector<Eigen::Vector2f> SimplifiedPDS(const Eigen::MatrixXf& density);
+	std::vector<Eigen::Vector2f> SimplifiedPDS(Rng& rng, const Eigen::MatrixXf& density);
 
-	std::vector<Eigen::Vector2f> SimplifiedPDSOld(const Eigen::MatrixXf& density);
+	std::vector<Eigen::Vector2f> SimplifiedPDSOld(Rng& rng, const Eigen::MatrixXf& density);
 
 	std::vector<Eigen::Vector2f> FloydSteinberg(const Eigen::MatrixXf& density);
 
 	std::vector<Eigen::Vector2f> FloydSteinbergExpo(const Eigen::MatrixXf& density);
 
-	std::vector<Eigen::Vector2f> FloydSteinbergMultiLayer(const Eigen::MatrixXf& density);
+	std::vector<Eigen::Vector2f> FloydSteinbergMultiLayer(Rng& rng, const Eigen::MatrixXf& density);
 
-	std::vector<Eigen::Vector2f> Fattal(const Eigen::MatrixXf& density);
+	std::vector<Eigen::Vector2f> Fattal(Rng& rng, const Eigen::MatrixXf& density);
 
 	std::vector<Eigen::Vector2f> DeltaDensitySampling(
+		Rng& rng,
 		const Eigen::MatrixXf& density,
 		const std::vector<Eigen::Vector2f>& old_seeds,
 		std::vector<int>* seed_origin = 0
 	);
 
-	std::vector<Eigen::Vector2f> DeltaDensitySamplingOld(const Eigen::MatrixXf& density, const std::vector<Eigen::Vector2f>& old_seeds);
+	std::vector<Eigen::Vector2f> DeltaDensitySamplingOld(Rng& rng, const Eigen::MatrixXf& density, const std::vector<Eigen::Vector2f>& old_seeds);
 
-	inline std::vector<Eigen::Vector2f> PoissonDiscSampling(const std::string& name, const Eigen::MatrixXf& density, const std::vector<Eigen::Vector2f>& old_points = std::vector<Eigen::Vector2f>())
+	/** Samples points with the given method
+	 * The result only depends on the state of rng and not on threading.
+	 */
+	inline std::vector<Eigen::Vector2f> PoissonDiscSampling(const std::string& name, Rng& rng, const Eigen::MatrixXf& density, const std::vector<Eigen::Vector2f>& old_points = std::vector<Eigen::Vector2f>())
 	{
-		if(name == "rnd") return Random(density);
+		if(name == "rnd") return Random(rng, density);
 		if(name == "rect") return RectGrid(density);
-		if(name == "spds") return SimplifiedPDS(density);
-		if(name == "fattal") return Fattal(density);
-		if(name == "dds") return DeltaDensitySampling(density, old_points);
+		if(name == "spds") return SimplifiedPDS(rng, density);
+		if(name == "fattal") return Fattal(rng, density);
+		if(name == "dds") return DeltaDensitySampling(rng, density, old_points);
 		throw 0;
 	}
 
@@ -0,0 +1,136 @@
+#ifndef INCLUDED_PDS_RNG_HPP
+#define INCLUDED_PDS_RNG_HPP
+
+#include <cstdint>
+#include <cmath>
+
+namespace pds
+{
+
+	/** Counter-based random number generator (Philox-4x32-10)
+	 * The n-th number of a generator is a pure function of (seed, stream, n).
+	 * Independent generators can be derived with 'stream' and consumed on any
+	 * thread and in any order while the results stay reproducible for a seed.
+	 * Models the UniformRandomNumberGenerator concept of boost and std.
+	 */
+	class Rng
+	{
+	public:
+		typedef uint32_t result_type;
+
+		explicit Rng(uint64_t seed=0, uint64_t stream=0) {
+			this->seed(seed, stream);
+		}
+
+		static constexpr result_type min() { return 0; }
+
+		static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+		void seed(uint64_t seed, uint64_t stream=0) {
+			key_[0] = static_cast<uint32_t>(seed);
+			key_[1] = static_cast<uint32_t>(seed >> 32);
+			stream_ = stream;
+			counter_ = 0;
+			buffer_pos_ = 4;
+			has_normal_ = false;
+		}
+
+		result_type operator()() {
+			if(buffer_pos_ == 4) {
+				const uint32_t ctr[4] = {
+					static_cast<uint32_t>(counter_), static_cast<uint32_t>(counter_ >> 32),
+					static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)
+				};
+				Philox(ctr, key_, buffer_);
+				counter_ ++;
+				buffer_pos_ = 0;
+			}
+			return buffer_[buffer_pos_++];
+		}
+
+		/** Derives an independent generator with the same seed
+		 * Does not advance this generator. Derived generators can be derived again,
+		 * e.g. rng.stream(frame).stream(cell).
+		 */
+		Rng stream(uint64_t id) const {
+			const uint32_t ctr[4] = {
+				static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32),
+				static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)
+			};
+			// use a different key than for number generation to separate both domains
+			const uint32_t key[2] = { key_[0] ^ 0x5851F42Du, key_[1] ^ 0x4C957F2Du };
+			uint32_t out[4];
+			Philox(ctr, key, out);
+			Rng r;
+			r.key_[0] = key_[0];
+			r.key_[1] = key_[1];
+			r.stream_ = (static_cast<uint64_t>(out[1]) << 32) | static_cast<uint64_t>(out[0]);
+			return r;
+		}
+
+		/** Uniformly distributed in [0,1[ */
+		float uniform01() {
+			return static_cast<float>((*this)() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		/** Uniformly distributed in [a,b[ */
+		float uniform(float a, float b) {
+			return a + (b - a) * uniform01();
+		}
+
+		/** Uniformly distributed integer in [0,n[ */
+		unsigned int uniformInt(unsigned int n) {
+			return static_cast<unsigned int>((static_cast<uint64_t>((*this)()) * static_cast<uint64_t>(n)) >> 32);
+		}
+
+		/** Standard normal distribution (Box-Muller) */
+		float normal() {
+			if(has_normal_) {
+				has_normal_ = false;
+				return normal_;
+			}
+			constexpr float cTwoPi = 6.283185307f;
+			const float u1 = 1.0f - uniform01(); // in ]0,1]
+			const float u2 = uniform01();
+			const float r = std::sqrt(-2.0f * std::log(u1));
+			normal_ = r * std::sin(cTwoPi * u2);
+			has_normal_ = true;
+			return r * std::cos(cTwoPi * u2);
+		}
+
+	private:
+		static void Philox(const uint32_t* ctr_in, const uint32_t* key_in, uint32_t* out) {
+			constexpr uint32_t M0 = 0xD2511F53u;
+			constexpr uint32_t M1 = 0xCD9E8D57u;
+			constexpr uint32_t W0 = 0x9E3779B9u;
+			constexpr uint32_t W1 = 0xBB67AE85u;
+			uint32_t c0 = ctr_in[0], c1 = ctr_in[1], c2 = ctr_in[2], c3 = ctr_in[3];
+			uint32_t k0 = key_in[0], k1 = key_in[1];
+			for(unsigned int i=0; i<10; i++) {
+				const uint64_t p0 = static_cast<uint64_t>(M0) * static_cast<uint64_t>(c0);
+				const uint64_t p1 = static_cast<uint64_t>(M1) * static_cast<uint64_t>(c2);
+				c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+				c1 = static_cast<uint32_t>(p1);
+				c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+				c3 = static_cast<uint32_t>(p0);
+				k0 += W0;
+				k1 += W1;
+			}
+			out[0] = c0;
+			out[1] = c1;
+			out[2] = c2;
+			out[3] = c3;
+		}
+
+		uint32_t key_[2];
+		uint64_t stream_;
+		uint64_t counter_;
+		uint32_t buffer_[4];
+		unsigned int buffer_pos_;
+		float normal_;
+		bool has_normal_;
+	};
+
+}
+
+#endif
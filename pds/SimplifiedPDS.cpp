@@ -2,6 +2,8 @@
 #include "PDS.hpp"
 #include "Tools.hpp"
 #include <density/ScalePyramid.hpp>
+#include <Danvil/Tools/Parallel.h>
+#include <algorithm>
 #include <iostream>
 
 namespace pds
@@ -12,105 +14,146 @@ namespace pds
 
 		constexpr float GAMMA = 0.38f;
 
+		/** Subtrees at this level (cells of 128x128 pixels) are sampled in parallel */
+		constexpr int cTaskLevel = 7;
+
+		/** Expected number of seeds per worker thread
+		 * Sampling 1000 seeds takes about 0.13 ms while starting and joining a
+		 * thread takes about 15 us. Densities with fewer than two times this
+		 * number of seeds are sampled without worker threads.
+		 */
+		constexpr float cSeedsPerThread = 1000.0f;
+
+		/** Cell of the scale pyramid */
+		struct Cell
+		{
+			int level;
+			unsigned int x, y;
+		};
+
+		/** Unique id of a cell used to derive its random number stream */
+		inline uint64_t CellId(const Cell& c)
+		{
+			return (static_cast<uint64_t>(c.level) << 48) | (static_cast<uint64_t>(c.y) << 24) | static_cast<uint64_t>(c.x);
+		}
+
 		void spds_rec(
+				Rng& rng,
 				std::vector<Eigen::Vector2f>& seeds,
-				const std::vector<Eigen::MatrixXf>& mipmaps,
+				const density::ScalePyramid& mipmaps,
 				int level, unsigned int x, unsigned int y)
 		{
-			static boost::uniform_real<float> rnd(0.0f, 1.0f);
-			static boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(impl::Rnd(), rnd);
-
-			float v = mipmaps[level](x, y);
+			float v = mipmaps(level, x, y);
 
 //			std::cout << x << " " << y << " " << v << std::endl;
 
 			if(v > 4.0f && level > 1) {
 //				std::cout << "-> down" << std::endl;
-				// go down
-				spds_rec(seeds, mipmaps, level - 1, 2*x,     2*y    );
-				spds_rec(seeds, mipmaps, level - 1, 2*x,     2*y + 1);
-				spds_rec(seeds, mipmaps, level - 1, 2*x + 1, 2*y    );
-				spds_rec(seeds, mipmaps, level - 1, 2*x + 1, 2*y + 1);
+				// go down (children outside of the image have no density)
+				for(unsigned int i=0; i<4; i++) {
+					const unsigned int cx = 2*x + (i/2);
+					const unsigned int cy = 2*y + (i%2);
+					if(mipmaps.valid(level - 1, cx, cy)) {
+						spds_rec(rng, seeds, mipmaps, level - 1, cx, cy);
+					}
+				}
 			}
 			else {
-				unsigned int num = impl::RandomRound(v);
+				unsigned int num = impl::RandomRound(rng, v);
 //				std::cout << "sampling: num=" << num << std::endl;
 				// compute weight of children
-				const Eigen::MatrixXf& mmc = mipmaps[level-1];
 				std::vector<float> w {
-					mmc(2*x,     2*y    ),
-					mmc(2*x,     2*y + 1),
-					mmc(2*x + 1, 2*y    ),
-					mmc(2*x + 1, 2*y + 1)
+					mipmaps(level - 1, 2*x,     2*y    ),
+					mipmaps(level - 1, 2*x,     2*y + 1),
+					mipmaps(level - 1, 2*x + 1, 2*y    ),
+					mipmaps(level - 1, 2*x + 1, 2*y + 1)
 				};
 //				std::cout << "sampling: weights=" << w[0] << ", " << w[1] << ", " << w[2] << ", " << w[3] << std::endl;
 				// randomly select children based on weight and place points in cells
-				for(unsigned int i : impl::RandomSample(w, num)) {
+				for(unsigned int i : impl::RandomSample(rng, w, num)) {
 //					std::cout << i << std::endl;
 					seeds.push_back(
-						//impl::OptimalCellPoint(mipmaps[0], 1 << (level-1), 2*x + (i/2), 2*y + (i%2))
-						//impl::RandomCellPoint(1 << (level-1), 2*x + (i/2), 2*y + (i%2), GAMMA)
-						impl::ProbabilityCellPoint(mipmaps[0], 1 << (level-1), 2*x + (i/2), 2*y + (i%2), w[i])
+						//impl::OptimalCellPoint(mipmaps.level(0), 1 << (level-1), 2*x + (i/2), 2*y + (i%2))
+						//impl::RandomCellPoint(rng, 1 << (level-1), 2*x + (i/2), 2*y + (i%2), GAMMA)
+						impl::ProbabilityCellPoint(rng, mipmaps.level(0), 1 << (level-1), 2*x + (i/2), 2*y + (i%2), w[i])
 					);
 				}
 			}
 //			std::cout << "<- up" << std::endl;
 		}
 
-		std::vector<Eigen::Vector2f> spds_impl(const Eigen::MatrixXf& density)
+		/** Collects the cells in depth-first order at which spds_rec is started in parallel
+		 * Descends like spds_rec, but stops at cTaskLevel or if spds_rec would sample the cell.
+		 */
+		void collect_tasks(
+				const density::ScalePyramid& mipmaps,
+				int level, unsigned int x, unsigned int y,
+				std::vector<Cell>& tasks)
 		{
-			// compute mipmaps
-			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps(density, 1);
-		#ifdef CREATE_DEBUG_IMAGES
-			//DebugMipmap<2>(mipmaps, "mm");
-			for(unsigned int i=0; i<mipmaps.size(); i++) {
-				std::string tag = (boost::format("mm_%1d") % i).str();
-				DebugShowMatrix(mipmaps[i], tag);
-				DebugWriteMatrix(mipmaps[i], tag);
+			if(level > cTaskLevel && mipmaps(level, x, y) > 4.0f && level > 1) {
+				for(unsigned int i=0; i<4; i++) {
+					const unsigned int cx = 2*x + (i/2);
+					const unsigned int cy = 2*y + (i%2);
+					if(mipmaps.valid(level - 1, cx, cy)) {
+						collect_tasks(mipmaps, level - 1, cx, cy, tasks);
+					}
+				}
+			}
+			else {
+				tasks.push_back(Cell{level, x, y});
 			}
-		#endif
-			// sample points
-			std::vector<Eigen::Vector2f> seeds;
-			spds_rec(seeds, mipmaps, mipmaps.size() - 1, 0, 0);
-			// scale points with base constant
-			impl::ScalePoints(seeds, 2.f);
-			return seeds;
 		}
 
-		std::vector<Eigen::Vector2f> spds_impl_640x480(const Eigen::MatrixXf& density)
+		std::vector<Eigen::Vector2f> spds_impl(Rng& rng, const Eigen::MatrixXf& density)
 		{
 			// compute mipmaps
-			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps640x480(density);
+			const density::ScalePyramid mipmaps(density);
 		#ifdef CREATE_DEBUG_IMAGES
-			DebugMipmap<5>(mipmaps, "mm640");
-			for(unsigned int i=0; i<mipmaps.size(); i++) {
-				std::string tag = (boost::format("mm640_%1d") % i).str();
-				DebugShowMatrix(mipmaps[i], tag);
-				DebugWriteMatrix(mipmaps[i], tag);
+			for(unsigned int i=0; i<mipmaps.numLevels(); i++) {
+				std::string tag = (boost::format("mm_%1d") % i).str();
+				DebugShowMatrix(mipmaps.level(i), tag);
+				DebugWriteMatrix(mipmaps.level(i), tag);
 			}
 		#endif
-			// now create pixel seeds
+			if(mipmaps.numLevels() <= 1) {
+				return {};
+			}
+			const int top = mipmaps.numLevels() - 1;
+			const float expected = mipmaps(top, 0, 0);
+			if(expected < 2.0f*cSeedsPerThread) {
+				// small problems are sampled directly on the calling thread
+				std::vector<Eigen::Vector2f> seeds;
+				spds_rec(rng, seeds, mipmaps, top, 0, 0);
+				return seeds;
+			}
+			// sample subtrees in parallel with one random number stream per cell
+			const unsigned int num_threads = std::min<unsigned int>(Danvil::ThreadCount(), static_cast<unsigned int>(expected / cSeedsPerThread));
+			std::vector<Cell> tasks;
+			collect_tasks(mipmaps, top, 0, 0, tasks);
+			const Rng base = rng.stream(rng());
+			std::vector<std::vector<Eigen::Vector2f>> task_seeds(tasks.size());
+			Danvil::ParallelFor(tasks.size(),
+				[&tasks, &task_seeds, &mipmaps, &base](std::size_t i) {
+					Rng task_rng = base.stream(CellId(tasks[i]));
+					spds_rec(task_rng, task_seeds[i], mipmaps, tasks[i].level, tasks[i].x, tasks[i].y);
+				}, 1, num_threads);
+			// concatenate in the order of the cells
+			std::size_t num = 0;
+			for(const std::vector<Eigen::Vector2f>& v : task_seeds) {
+				num += v.size();
+			}
 			std::vector<Eigen::Vector2f> seeds;
-			const unsigned int l0 = mipmaps.size() - 1;
-			for(unsigned int y=0; y<mipmaps[l0].cols(); ++y) {
-				for(unsigned int x=0; x<mipmaps[l0].rows(); x++) {
-					spds_rec(seeds, mipmaps, l0, x, y);
-				}
+			seeds.reserve(num);
+			for(const std::vector<Eigen::Vector2f>& v : task_seeds) {
+				seeds.insert(seeds.end(), v.begin(), v.end());
 			}
-			// scale points with base constant
-			impl::ScalePoints(seeds, 5.f);
 			return seeds;
 		}
 	}
 
-	std::vector<Eigen::Vector2f> SimplifiedPDS(const Eigen::MatrixXf& density)
+	std::vector<Eigen::Vector2f> SimplifiedPDS(Rng& rng, const Eigen::MatrixXf& density)
 	{
-		if(density.rows() == 640 && density.cols() == 480) {
-			return spds::spds_impl_640x480(density);
-		}
-		else {
-			return spds::spds_impl(density);
-		}
+		return spds::spds_impl(rng, density);
 	}
 
 }
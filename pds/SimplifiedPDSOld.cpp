@@ -10,31 +10,29 @@ namespace pds
 	{
 
 		void FindSeedsDepthMipmap_Walk(
+				Rng& rng,
 				std::vector<Eigen::Vector2f>& seeds,
 				const std::vector<Eigen::MatrixXf>& mipmaps,
 				int level, unsigned int x, unsigned int y)
 		{
-			static boost::uniform_real<float> rnd(0.0f, 1.0f);
-			static boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > die(impl::Rnd(), rnd);
-
 			float v = mipmaps[level](x, y);
 
 			if(v > 1.0f && level > 0) { // do not access mipmap 0!
 				// go down
-				FindSeedsDepthMipmap_Walk(seeds, mipmaps, level - 1, 2*x,     2*y    );
-				FindSeedsDepthMipmap_Walk(seeds, mipmaps, level - 1, 2*x,     2*y + 1);
-				FindSeedsDepthMipmap_Walk(seeds, mipmaps, level - 1, 2*x + 1, 2*y    );
-				FindSeedsDepthMipmap_Walk(seeds, mipmaps, level - 1, 2*x + 1, 2*y + 1);
+				FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, level - 1, 2*x,     2*y    );
+				FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, level - 1, 2*x,     2*y + 1);
+				FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, level - 1, 2*x + 1, 2*y    );
+				FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, level - 1, 2*x + 1, 2*y + 1);
 			}
 			else {
-				if(die() <= v) {
+				if(rng.uniform01() <= v) {
 					seeds.push_back(
-						impl::RandomCellPoint(1 << level, x, y, 0.38f));
+						impl::RandomCellPoint(rng, 1 << level, x, y, 0.38f));
 				}
 			}
 		}
 
-		std::vector<Eigen::Vector2f> FindSeedsDepthMipmap(const Eigen::MatrixXf& density)
+		std::vector<Eigen::Vector2f> FindSeedsDepthMipmap(Rng& rng, const Eigen::MatrixXf& density)
 		{
 			// compute mipmaps
 			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps(density, 1);
@@ -48,13 +46,13 @@ namespace pds
 		#endif
 			// sample points
 			std::vector<Eigen::Vector2f> seeds;
-			FindSeedsDepthMipmap_Walk(seeds, mipmaps, mipmaps.size() - 1, 0, 0);
+			FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, mipmaps.size() - 1, 0, 0);
 			// scale points with base constant
 			impl::ScalePoints(seeds, 2.f);
 			return seeds;
 		}
 
-		std::vector<Eigen::Vector2f> FindSeedsDepthMipmap640(const Eigen::MatrixXf& density)
+		std::vector<Eigen::Vector2f> FindSeedsDepthMipmap640(Rng& rng, const Eigen::MatrixXf& density)
 		{
 			// compute mipmaps
 			std::vector<Eigen::MatrixXf> mipmaps = density::ComputeMipmaps640x480(density);
@@ -71,7 +69,7 @@ namespace pds
 			const unsigned int l0 = mipmaps.size() - 1;
 			for(unsigned int y=0; y<mipmaps[l0].cols(); ++y) {
 				for(unsigned int x=0; x<mipmaps[l0].rows(); x++) {
-					FindSeedsDepthMipmap_Walk(seeds, mipmaps, l0, x, y);
+					FindSeedsDepthMipmap_Walk(rng, seeds, mipmaps, l0, x, y);
 				}
 			}
 			// scale points with base constant
@@ -80,13 +78,13 @@ namespace pds
 		}
 	}
 
-	std::vector<Eigen::Vector2f> SimplifiedPDSOld(const Eigen::MatrixXf& density)
+	std::vector<Eigen::Vector2f> SimplifiedPDSOld(Rng& rng, const Eigen::MatrixXf& density)
 	{
 		if(density.rows() == 640 && density.cols() == 480) {
-			return spds_old::FindSeedsDepthMipmap640(density);
+			return spds_old::FindSeedsDepthMipmap640(rng, density);
 		}
 		else {
-			return spds_old::FindSeedsDepthMipmap(density);
+			return spds_old::FindSeedsDepthMipmap(rng, density);
 		}
 	}
 
@@ -1,33 +1,36 @@
 #ifndef INCLUDED_PDS_TOOLS_HPP
 #define INCLUDED_PDS_TOOLS_HPP
 
-#include <boost/random.hpp>
+#include "Rng.hpp"
+#include <Eigen/Dense>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cassert>
 
 namespace pds
 {
 
 	namespace impl
 	{
-		inline boost::mt19937& Rnd()
-		{
-			static boost::mt19937 rnd;
-			return rnd;
-		}
-
-		inline void RndSeed(unsigned int x)
-		{
-			Rnd().seed(x);
-		}
-		
 		/** Selects a random point in the tree node using uniform distribution */ 
-		inline Eigen::Vector2f RandomCellPoint(int scale, int x, int y, float gamma)
+		inline Eigen::Vector2f RandomCellPoint(Rng& rng, int scale, int x, int y, float gamma)
 		{
 			float sf = static_cast<float>(scale);
 			float xf = static_cast<float>(x);
 			float yf = static_cast<float>(y);
-			boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > delta(
-					Rnd(), boost::uniform_real<float>(0.5f-gamma, 0.5f+gamma));
-			return Eigen::Vector2f(sf*(xf + delta()), sf*(yf + delta()));
+			float dx = rng.uniform(0.5f-gamma, 0.5f+gamma);
+			float dy = rng.uniform(0.5f-gamma, 0.5f+gamma);
+			return Eigen::Vector2f(sf*(xf + dx), sf*(yf + dy));
+		}
+
+		/** Selects a random point in the rectangle with corner (x,y) and size (w,h) using uniform distribution */
+		inline Eigen::Vector2f RandomRectPoint(Rng& rng, float x, float y, float w, float h, float gamma)
+		{
+			float dx = rng.uniform(0.5f-gamma, 0.5f+gamma);
+			float dy = rng.uniform(0.5f-gamma, 0.5f+gamma);
+			return Eigen::Vector2f(x + w*dx, y + h*dy);
 		}
 
 		/** Selects the point in the tree node with highest probability */ 
@@ -54,7 +57,7 @@ namespace pds
 		/** Randomly selects a point in the given tree node by considering probabilities 
 		 * Runtime: O(S*S + log(S*S))
 		 */
-		inline Eigen::Vector2f ProbabilityCellPoint(const Eigen::MatrixXf& m0, int scale, int x, int y)
+		inline Eigen::Vector2f ProbabilityCellPoint(Rng& rng, const Eigen::MatrixXf& m0, int scale, int x, int y)
 		{
 			x *= scale;
 			y *= scale;
@@ -74,9 +77,7 @@ namespace pds
 				}
 			}
 			// sample in cdf
-			boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > rnd(
-					Rnd(), boost::uniform_real<float>(0.0f, cdf.back()));
-			float v = rnd();
+			float v = rng.uniform(0.0f, cdf.back());
 			// find sample
 			auto it = std::lower_bound(cdf.begin(), cdf.end(), v);
 			int pos = std::distance(cdf.begin(), it);
@@ -85,20 +86,21 @@ namespace pds
 
 		/** Randomly selects a point in the given tree node by considering probabilities
 		 * Assumes that cdf_sum is the probability sum in the given tree node
+		 * Tree nodes at the border may only partially cover m0.
 		 * Runtime: O(S*S/2)
 		 */
-		inline Eigen::Vector2f ProbabilityCellPoint(const Eigen::MatrixXf& m0, int scale, int x, int y, float cdf_sum)
+		inline Eigen::Vector2f ProbabilityCellPoint(Rng& rng, const Eigen::Ref<const Eigen::MatrixXf>& m0, int scale, int x, int y, float cdf_sum)
 		{
 			// sample in cdf
-			boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > rnd(
-					Rnd(), boost::uniform_real<float>(0.0f, cdf_sum));
-			float v = rnd();
+			float v = rng.uniform(0.0f, cdf_sum);
 			// find sample
 			x *= scale;
 			y *= scale;
-			const auto& b = m0.block(x, y, scale, scale);
-			for(int i=0; i<scale; ++i) {
-				for(int j=0; j<scale; ++j) {
+			const int sx = std::min<int>(scale, m0.rows() - x);
+			const int sy = std::min<int>(scale, m0.cols() - y);
+			const auto& b = m0.block(x, y, sx, sy);
+			for(int i=0; i<sy; ++i) {
+				for(int j=0; j<sx; ++j) {
 					v -= b(j,i);
 					if(v <= 0.0f) {
 						return Eigen::Vector2f(x + j, y + i);
@@ -107,7 +109,7 @@ namespace pds
 			}
 			// should never be here
 			assert(false);
-			return Eigen::Vector2f(x + scale/2, y + scale/2);
+			return Eigen::Vector2f(x + sx/2, y + sy/2);
 		}
 
 		inline void ScalePoints(std::vector<Eigen::Vector2f>& pnts, float scale)
@@ -118,30 +120,26 @@ namespace pds
 		}
 
 		/** Randomly rounds a float up or down s.t. the expected value is the given value */
-		inline unsigned int RandomRound(float x)
+		inline unsigned int RandomRound(Rng& rng, float x)
 		{
 			if(x <= 0.0f) {
 				return 0;
 			}
 			float a = std::floor(x);
 			float r = x - a;
-			boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > uniform01(
-					Rnd(), boost::uniform_real<float>(0.0f,1.0f));
-			return a + (uniform01() >= r ? 0.0f : 1.0f);
+			return a + (rng.uniform01() >= r ? 0.0f : 1.0f);
 		}
 
-		inline std::vector<unsigned int> RandomSample(const std::vector<float>& v, unsigned int num)
+		inline std::vector<unsigned int> RandomSample(Rng& rng, const std::vector<float>& v, unsigned int num)
 		{
 			std::vector<float> a(v.size());
 			std::partial_sum(v.begin(), v.end(), a.begin());
 //			std::copy(a.begin(), a.end(), std::ostream_iterator<float>(std::cout, ", "));
 			float ws = a.back();
-			boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > rndv(
-					Rnd(), boost::uniform_real<float>(0.0f, ws));
 			std::vector<unsigned int> idx(num);
 			std::generate(idx.begin(), idx.end(),
-				[&rndv,&a]() -> unsigned int {
-					float x = rndv();
+				[&rng,&a,ws]() -> unsigned int {
+					float x = rng.uniform(0.0f, ws);
 					auto it = std::lower_bound(a.begin(), a.end(), x);
 					if(it == a.end()) {
 						return a.size() - 1;
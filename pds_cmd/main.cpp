@@ -39,6 +39,7 @@ int main(int argc, char** argv)
 	std::string p_out = "pnts.tsv";
 	unsigned p_size = 128;
 	unsigned p_num = 250;
+	unsigned p_seed = 0;
 
 	namespace po = boost::program_options;
 	po::options_description desc;
@@ -49,6 +50,7 @@ int main(int argc, char** argv)
 		("out", po::value(&p_out), "filename of result file with samples points")
 		("size", po::value(&p_size), "size of image in pixel")
 		("num", po::value(&p_num), "number of points to sample")
+		("seed", po::value(&p_seed), "random number seed")
 	;
 
 	po::variables_map vm;
@@ -76,7 +78,8 @@ int main(int argc, char** argv)
 	std::vector<Eigen::Vector2f> pnts;
 	{
 		boost::timer::auto_cpu_timer t;
-		pnts = pds::PoissonDiscSampling(p_mode, rho);
+		pds::Rng rng(p_seed);
+		pnts = pds::PoissonDiscSampling(p_mode, rng, rho);
 	}
 	std::cout << "Generated " << pnts.size() << " points." << std::endl;
 